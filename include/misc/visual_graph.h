@@ -6,6 +6,8 @@
 #include <SFML/Window.hpp>
 #include <SFML/Graphics.hpp>
 #include <graph.h>
+#include <graph_bfs.h>
+#include <graph_dfs.h>
 #include <fstream>
 #include <string>
 #include <text_circle.h>
@@ -61,7 +63,7 @@ namespace misc
 
 		void breadth_first(std::map<int, float>& traversal_map, int start_node);
 
-		void depth_first(std::map<int, float>& traversal_map, int start_node, int cur_node);
+		void depth_first(std::map<int, float>& traversal_map, int start_node);
 
 		bool mouse_check(sf::Vector2f mouse_pos);
 
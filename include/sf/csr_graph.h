@@ -0,0 +1,285 @@
+#pragma once
+#include <array_list.h>
+#include <unordered_map.h>
+
+namespace ssuds
+{
+	// Forward declaration (graph.h includes this file so Graph can offer a freeze method)
+	template <class N, class E>
+	class Graph;
+
+	/// <summary>
+	/// A read-only "compressed sparse row" snapshot of a Graph.  Every node is given a dense
+	/// index (0...num_nodes-1) and all edges are packed into three contiguous arrays:
+	///     offsets: the edges leaving node i are stored at [offsets[i], offsets[i + 1])
+	///     targets: the dense index of the destination node of each edge
+	///     weights: the edge value of each edge
+	/// Traversals over this structure walk plain arrays rather than hash-table entries, which
+	/// is much friendlier to the cache on large graphs.  Changes made to the original Graph
+	/// after the snapshot is taken are NOT reflected here (call Graph::freeze again).
+	/// </summary>
+	/// <typeparam name="N">The type of Nodes/Vertices</typeparam>
+	/// <typeparam name="E">The type of Edges</typeparam>
+	template <class N, class E>
+	class CsrGraph
+	{
+	protected:
+		/// <summary>
+		/// The node value of each dense index
+		/// </summary>
+		ArrayList<N> mNodes;
+
+		/// <summary>
+		/// Maps a node value back to its dense index
+		/// </summary>
+		UnorderedMap<N, unsigned int> mIndices;
+
+		/// <summary>
+		/// Where each node's outgoing edges start in mTargets / mWeights (this has num_nodes + 1 entries)
+		/// </summary>
+		ArrayList<unsigned int> mOffsets;
+
+		/// <summary>
+		/// The dense index of the destination node for every edge
+		/// </summary>
+		ArrayList<unsigned int> mTargets;
+
+		/// <summary>
+		/// The edge value for every edge (parallel to mTargets)
+		/// </summary>
+		ArrayList<E> mWeights;
+
+	public:
+		/// <summary>
+		/// Default constructor (an empty snapshot)
+		/// </summary>
+		CsrGraph()
+		{
+			mOffsets.append(0);
+		}
+
+
+		/// <summary>
+		/// Builds a snapshot of the given graph.  Nodes are numbered in the graph's iteration order.
+		/// </summary>
+		/// <param name="G">the graph to pack</param>
+		CsrGraph(const Graph<N, E>& G)
+		{
+			// Pass 1: hand out a dense index to every node
+			mIndices.reserve(G.num_nodes());
+			typename UnorderedMap<N, UnorderedMap<N, E>>::UnorderedMapIterator it = G.begin();
+			while (it != G.end())
+			{
+				mIndices[(*it).first] = mNodes.size();
+				mNodes.append((*it).first);
+				++it;
+			}
+
+			// Pass 2: pack the edges, node by node (in the same order as pass 1)
+			mOffsets.append(0);
+			it = G.begin();
+			while (it != G.end())
+			{
+				typename UnorderedMap<N, E>::UnorderedMapIterator inner_it = (*it).second.begin();
+				while (inner_it != (*it).second.end())
+				{
+					mTargets.append((*mIndices.find((*inner_it).first)).second);
+					mWeights.append((*inner_it).second);
+					++inner_it;
+				}
+				mOffsets.append(mTargets.size());
+				++it;
+			}
+		}
+
+
+		/// <summary>
+		/// Returns the number of nodes in the snapshot
+		/// </summary>
+		/// <returns>number of nodes</returns>
+		unsigned int num_nodes() const
+		{
+			return mNodes.size();
+		}
+
+
+		/// <summary>
+		/// Returns the number of edges in the snapshot
+		/// </summary>
+		/// <returns>number of edges</returns>
+		unsigned int num_edges() const
+		{
+			return mTargets.size();
+		}
+
+
+		/// <summary>
+		/// Finds the dense index of a node
+		/// </summary>
+		/// <param name="node">the node value</param>
+		/// <returns>the dense index, or -1 if that node is not in the snapshot</returns>
+		int index_of(const N& node) const
+		{
+			typename UnorderedMap<N, unsigned int>::UnorderedMapIterator it = mIndices.find(node);
+			if (it == mIndices.end())
+				return -1;
+			return (int)(*it).second;
+		}
+
+
+		/// <summary>
+		/// Gets the node value for a dense index (raises a std::out_of_range exception if index is invalid)
+		/// </summary>
+		/// <param name="index">dense index</param>
+		/// <returns>the node value</returns>
+		const N& node_at(unsigned int index) const
+		{
+			return mNodes[index];
+		}
+
+
+		/// <summary>
+		/// Returns the number of outgoing edges of the node with the given dense index
+		/// </summary>
+		/// <param name="index">dense index</param>
+		/// <returns>out-degree</returns>
+		unsigned int degree(unsigned int index) const
+		{
+			return mOffsets[index + 1] - mOffsets[index];
+		}
+
+
+		/// <summary>
+		/// Returns the position (in the edge arrays) of the first outgoing edge of a node.
+		/// Use with edge_end, target and weight to walk a node's neighbors:
+		///     for (unsigned int e = G.edge_begin(i); e &lt; G.edge_end(i); e++)
+		///         ... G.target(e) ... G.weight(e) ...
+		/// </summary>
+		/// <param name="index">dense index</param>
+		/// <returns>the first edge position</returns>
+		unsigned int edge_begin(unsigned int index) const
+		{
+			return mOffsets[index];
+		}
+
+
+		/// <summary>
+		/// Returns the position (in the edge arrays) one past the last outgoing edge of a node
+		/// </summary>
+		/// <param name="index">dense index</param>
+		/// <returns>the end edge position</returns>
+		unsigned int edge_end(unsigned int index) const
+		{
+			return mOffsets[index + 1];
+		}
+
+
+		/// <summary>
+		/// Gets the dense index of the destination of an edge
+		/// </summary>
+		/// <param name="edge">edge position</param>
+		/// <returns>dense index of the destination node</returns>
+		unsigned int target(unsigned int edge) const
+		{
+			return mTargets[edge];
+		}
+
+
+		/// <summary>
+		/// Gets the value of an edge
+		/// </summary>
+		/// <param name="edge">edge position</param>
+		/// <returns>the edge value</returns>
+		const E& weight(unsigned int edge) const
+		{
+			return mWeights[edge];
+		}
+
+
+		/// <summary>
+		/// Performs a breadth-first traversal from the given node.
+		/// </summary>
+		/// <param name="start">dense index of the starting node</param>
+		/// <returns>The parent (dense index) of each node in the traversal tree.  The start node is its own
+		/// parent and nodes that cannot be reached have a parent of -1</returns>
+		ArrayList<int> breadth_first(unsigned int start) const
+		{
+			ArrayList<int> parents = unreached_list();
+			parents[start] = start;
+
+			// A single array is used as the queue: everything in [head, size) is the frontier
+			ArrayList<unsigned int> queue;
+			queue.append(start);
+			for (unsigned int head = 0; head < queue.size(); head++)
+			{
+				unsigned int cur = queue[head];
+				for (unsigned int e = mOffsets[cur]; e < mOffsets[cur + 1]; e++)
+				{
+					unsigned int next = mTargets[e];
+					if (parents[next] == -1)
+					{
+						parents[next] = cur;
+						queue.append(next);
+					}
+				}
+			}
+			return parents;
+		}
+
+
+		/// <summary>
+		/// Performs a depth-first traversal from the given node.  This uses an explicit stack, so
+		/// long paths don't run out of call-stack space.
+		/// </summary>
+		/// <param name="start">dense index of the starting node</param>
+		/// <returns>The parent (dense index) of each node in the traversal tree.  The start node is its own
+		/// parent and nodes that cannot be reached have a parent of -1</returns>
+		ArrayList<int> depth_first(unsigned int start) const
+		{
+			ArrayList<int> parents = unreached_list();
+			parents[start] = start;
+
+			// For each node on the stack we remember which edge to try next
+			ArrayList<unsigned int> node_stack;
+			ArrayList<unsigned int> edge_stack;
+			node_stack.append(start);
+			edge_stack.append(mOffsets[start]);
+			while (node_stack.size() > 0)
+			{
+				unsigned int top = node_stack.size() - 1;
+				unsigned int cur = node_stack[top];
+				unsigned int e = edge_stack[top];
+				if (e == mOffsets[cur + 1])
+				{
+					// Out of neighbors -- back up
+					node_stack.remove(top, false);
+					edge_stack.remove(top, false);
+					continue;
+				}
+
+				edge_stack[top] = e + 1;
+				unsigned int next = mTargets[e];
+				if (parents[next] == -1)
+				{
+					parents[next] = cur;
+					node_stack.append(next);
+					edge_stack.append(mOffsets[next]);
+				}
+			}
+			return parents;
+		}
+
+	protected:
+		/// <summary>
+		/// Makes a list (one entry per node) filled with -1
+		/// </summary>
+		/// <returns>the new list</returns>
+		ArrayList<int> unreached_list() const
+		{
+			ArrayList<int> result;
+			for (unsigned int i = 0; i < mNodes.size(); i++)
+				result.append(-1);
+			return result;
+		}
+	};
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include <unordered_map.h>
+#include <csr_graph.h>
 #include <sstream>
+#include <stdexcept>
 
 namespace ssuds
 {
@@ -18,7 +20,70 @@ namespace ssuds
 		/// </summary>
 		typename UnorderedMap<N, UnorderedMap<N, E>> mData;
 
+		/// <summary>
+		/// The (optional) in-edge index: for each node, the set of nodes that have an edge leading to it (the
+		/// bool values are unused).  This is only maintained if mTrackIncoming is true.
+		/// </summary>
+		UnorderedMap<N, UnorderedMap<N, bool>> mIncoming;
+
+		/// <summary>
+		/// Are we maintaining mIncoming?
+		/// </summary>
+		bool mTrackIncoming;
+
 	public:
+		/// <summary>
+		/// Constructor
+		/// </summary>
+		/// <param name="track_incoming">if true, the graph maintains an index of incoming edges.  This costs
+		/// some memory and a little time in set_edge / remove_edge, but makes remove_node O(degree) rather
+		/// than O(V) and enables in_degree / find_incoming</param>
+		explicit Graph(bool track_incoming = false) : mTrackIncoming(track_incoming)
+		{
+			// empty, on purpose
+		}
+
+
+		/// <summary>
+		/// Starts maintaining the in-edge index (building it from the current edges).  No effect
+		/// if the index is already being maintained
+		/// </summary>
+		void enable_incoming_index()
+		{
+			if (mTrackIncoming)
+				return;
+			mTrackIncoming = true;
+			mIncoming.clear();
+			mIncoming.reserve(mData.size());
+			typename UnorderedMap<N, UnorderedMap<N, E>>::UnorderedMapIterator it = mData.begin();
+			while (it != mData.end())
+			{
+				mIncoming[(*it).first];
+				++it;
+			}
+			it = mData.begin();
+			while (it != mData.end())
+			{
+				typename UnorderedMap<N, E>::UnorderedMapIterator inner_it = (*it).second.begin();
+				while (inner_it != (*it).second.end())
+				{
+					mIncoming[(*inner_it).first][(*it).first] = true;
+					++inner_it;
+				}
+				++it;
+			}
+		}
+
+
+		/// <summary>
+		/// Returns true if the in-edge index is being maintained
+		/// </summary>
+		/// <returns>true if in-edges are tracked</returns>
+		bool tracks_incoming() const
+		{
+			return mTrackIncoming;
+		}
+
 		/// <summary>
 		/// Adds a node to the graph (no effect if this Node already exists)
 		/// </summary>
@@ -28,6 +93,36 @@ namespace ssuds
 			// This seems like it's too simple, but by doing this we 
 			// do create the node.  If it's already there, this does nothing
 			mData[val];
+			if (mTrackIncoming)
+				mIncoming[val];
+		}
+
+
+		/// <summary>
+		/// Makes room for num_nodes nodes, so adding that many does no re-hashing (use this before
+		/// loading a graph whose size is known)
+		/// </summary>
+		/// <param name="num_nodes">the expected number of nodes</param>
+		void reserve_nodes(unsigned int num_nodes)
+		{
+			mData.reserve(num_nodes);
+			if (mTrackIncoming)
+				mIncoming.reserve(num_nodes);
+		}
+
+
+		/// <summary>
+		/// Makes room for num_edges edges leaving node, so adding that many does no re-hashing.  A
+		/// std::out_of_range exception is thrown if the node does not exist
+		/// </summary>
+		/// <param name="node">the start node of the edges</param>
+		/// <param name="num_edges">the expected number of edges leaving node</param>
+		void reserve_edges(const N& node, unsigned int num_edges)
+		{
+			typename UnorderedMap<N, UnorderedMap<N, E>>::UnorderedMapIterator it = mData.find(node);
+			if (it == mData.end())
+				throw std::out_of_range("Invalid node -- add this node before reserving edges for it");
+			(*it).second.reserve(num_edges);
 		}
 
 
@@ -97,16 +192,23 @@ namespace ssuds
 				throw std::out_of_range("Invalid start node -- add this node before adding edges from it");
 
 			(*it).second[destination] = edge_value;
+			if (mTrackIncoming)
+				mIncoming[destination][start] = true;
 		}
 
 
 		/// <summary>
-		/// Removes the node and all edges to / from it in the graph
+		/// Removes the node and all edges to / from it in the graph.  Finding the edges leading to this
+		/// node requires a scan of every node (O(V)) unless the in-edge index is maintained, in which
+		/// case this is O(degree)
 		/// </summary>
 		/// <param name="node">node to remove</param>
 		/// <returns>true if that node was removed (false if it didn't exist)</returns>
 		bool remove_node(const N& node)
 		{
+			if (mTrackIncoming)
+				return remove_node_indexed(node);
+
 			// The sneaky part: remove nodes going TO this one
 			typename UnorderedMap<N, UnorderedMap<N, E>>::UnorderedMapIterator it = mData.begin();
 			while (it != mData.end())
@@ -143,6 +245,8 @@ namespace ssuds
 				if (inner_it != (*it).second.end())
 				{
 					(*it).second.remove(destination_node);
+					if (mTrackIncoming)
+						(*mIncoming.find(destination_node)).second.remove(start_node);
 					return true;
 				}
 			}
@@ -167,10 +271,55 @@ namespace ssuds
 		/// <returns>the number of neighbors</returns>
 		unsigned int num_neighbors(const N& start_node) const
 		{
-			typename UnorderedMap<N, E>::UnorderedMapIterator it = mData.find(start_node);
+			typename UnorderedMap<N, UnorderedMap<N, E>>::UnorderedMapIterator it = mData.find(start_node);
 			if (it == end())
 				throw std::out_of_range("Invalid node");
-			return it.second.size();
+			return (unsigned int)(*it).second.size();
+		}
+
+
+		/// <summary>
+		/// Returns the number of incoming edges to this node.  This is O(1) if the in-edge index is
+		/// being maintained, O(V) if not.
+		/// </summary>
+		/// <param name="node">the node in question</param>
+		/// <returns>the number of nodes with an edge to this node</returns>
+		unsigned int in_degree(const N& node) const
+		{
+			if (mTrackIncoming)
+			{
+				typename UnorderedMap<N, UnorderedMap<N, bool>>::UnorderedMapIterator it = mIncoming.find(node);
+				if (it == mIncoming.end())
+					throw std::out_of_range("Invalid node");
+				return (unsigned int)(*it).second.size();
+			}
+
+			if (mData.find(node) == mData.end())
+				throw std::out_of_range("Invalid node");
+			unsigned int count = 0;
+			typename UnorderedMap<N, UnorderedMap<N, E>>::UnorderedMapIterator it = mData.begin();
+			while (it != mData.end())
+			{
+				if ((*it).second.find(node) != (*it).second.end())
+					count++;
+				++it;
+			}
+			return count;
+		}
+
+
+		/// <summary>
+		/// Returns an iterator referring to the given node's incoming-edge set (or an end iterator if that
+		/// node is not found).  The .second of the result is a map whose keys are the nodes with an edge
+		/// to this node.  A std::logic_error is thrown if the in-edge index is not being maintained.
+		/// </summary>
+		/// <param name="node">The node we're searching for</param>
+		/// <returns>an iterator</returns>
+		typename UnorderedMap<N, UnorderedMap<N, bool>>::UnorderedMapIterator find_incoming(const N& node) const
+		{
+			if (!mTrackIncoming)
+				throw std::logic_error("The in-edge index is not enabled for this graph");
+			return mIncoming.find(node);
 		}
 
 
@@ -203,15 +352,63 @@ namespace ssuds
 			return mData.end();
 		}
 
+		/// <summary>
+		/// Packs the current nodes and edges into a read-only, cache-friendly CsrGraph snapshot.  This is
+		/// an O(V + E) operation, so it is best done once before running many traversals.
+		/// </summary>
+		/// <returns>the snapshot</returns>
+		CsrGraph<N, E> freeze() const
+		{
+			return CsrGraph<N, E>(*this);
+		}
+
 		/// <summary>
 		/// Removes all nodes and edges in the graph
 		/// </summary>
 		void clear()
 		{
 			mData.clear();
+			mIncoming.clear();
 		}
 
 
+	protected:
+		/// <summary>
+		/// The O(degree) version of remove_node, used when the in-edge index is being maintained
+		/// </summary>
+		/// <param name="node">node to remove</param>
+		/// <returns>true if that node was removed (false if it didn't exist)</returns>
+		bool remove_node_indexed(const N& node)
+		{
+			typename UnorderedMap<N, UnorderedMap<N, E>>::UnorderedMapIterator out_it = mData.find(node);
+			if (out_it == mData.end())
+				return false;
+			typename UnorderedMap<N, UnorderedMap<N, bool>>::UnorderedMapIterator in_it = mIncoming.find(node);
+
+			// Our successors no longer have an edge from us
+			typename UnorderedMap<N, E>::UnorderedMapIterator succ_it = (*out_it).second.begin();
+			while (succ_it != (*out_it).second.end())
+			{
+				if (!((*succ_it).first == node))
+					(*mIncoming.find((*succ_it).first)).second.remove(node);
+				++succ_it;
+			}
+
+			// Our predecessors no longer have an edge to us
+			typename UnorderedMap<N, bool>::UnorderedMapIterator pred_it = (*in_it).second.begin();
+			while (pred_it != (*in_it).second.end())
+			{
+				if (!((*pred_it).first == node))
+					(*mData.find((*pred_it).first)).second.remove(node);
+				++pred_it;
+			}
+
+			mData.remove(node);
+			mIncoming.remove(node);
+			return true;
+		}
+
+	public:
 		/// <summary>
 		/// Outputs the graph to the given output stream in adjacency list style
 		/// </summary>
@@ -0,0 +1,511 @@
+#pragma once
+#include <graph.h>
+#include <csr_graph.h>
+#include <cstdint>
+#include <stdexcept>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace ssuds
+{
+	/// <summary>
+	/// A re-usable, direction-optimizing breadth-first search engine (see Beamer, Asanovic and Patterson,
+	/// "Direction-Optimizing Breadth-First Search").  Each level is expanded in one of two ways:
+	///   - top-down: every frontier node checks its outgoing edges for unvisited nodes (cheap for small frontiers)
+	///   - bottom-up: every unvisited node checks its incoming edges for a frontier node and stops at the first
+	///     one it finds (cheap for huge frontiers, which are common in low-diameter graphs)
+	/// The engine picks whichever is expected to check fewer edges.  Visited / frontier sets are dense bitmaps
+	/// and the frontier buffers are allocated once and re-used for every level and every run.
+	///
+	/// The traversal tree is canonical: every node's parent is the lowest-indexed (in the CsrGraph) node of the
+	/// previous level with an edge to it, whichever direction was used.
+	/// </summary>
+	/// <typeparam name="N">The type of Nodes/Vertices</typeparam>
+	/// <typeparam name="E">The type of Edges</typeparam>
+	template <class N, class E>
+	class BreadthFirstSearch
+	{
+	protected:
+		/// <summary>
+		/// The snapshot of the graph we're searching
+		/// </summary>
+		CsrGraph<N, E> mGraph;
+
+		/// <summary>
+		/// The transpose of mGraph (incoming edges), in CSR form: the sources of the edges into node i are
+		/// mInSources[mInOffsets[i]...mInOffsets[i+1]-1], in increasing order
+		/// </summary>
+		ArrayList<unsigned int> mInOffsets;
+
+		/// <summary>
+		/// See mInOffsets
+		/// </summary>
+		ArrayList<unsigned int> mInSources;
+
+		/// <summary>
+		/// One bit per node: has it been reached?
+		/// </summary>
+		ArrayList<std::uint64_t> mVisited;
+
+		/// <summary>
+		/// One bit per node: is it in the current frontier? (only used by bottom-up steps)
+		/// </summary>
+		ArrayList<std::uint64_t> mFrontierBits;
+
+		/// <summary>
+		/// One bit per node: is it in the next frontier? (only used by bottom-up steps)
+		/// </summary>
+		ArrayList<std::uint64_t> mNextBits;
+
+		/// <summary>
+		/// Two node lists (each with room for every node) used as the current and next frontier by top-down
+		/// steps.  mFrontierLists[mCurList] is the current frontier; only its first frontier_size entries are used.
+		/// </summary>
+		ArrayList<unsigned int> mFrontierLists[2];
+
+		/// <summary>
+		/// Which of mFrontierLists holds the current frontier
+		/// </summary>
+		unsigned int mCurList;
+
+		/// <summary>
+		/// The traversal-tree parent of each node (-1 if not reached; the start node is its own parent)
+		/// </summary>
+		ArrayList<int> mParents;
+
+		/// <summary>
+		/// The distance (in edges) of each node from the start (-1 if not reached)
+		/// </summary>
+		ArrayList<int> mLevels;
+
+		/// <summary>
+		/// Switch to bottom-up when (edges out of the frontier) > (edges out of unvisited nodes) / mAlpha.
+		/// A value of 0 disables bottom-up steps.
+		/// </summary>
+		double mAlpha;
+
+		/// <summary>
+		/// Switch back to top-down when (frontier size) &lt; (number of nodes) / mBeta
+		/// </summary>
+		double mBeta;
+
+		/// <summary>
+		/// How many levels of the last run were expanded bottom-up
+		/// </summary>
+		unsigned int mBottomUpSteps;
+
+	public:
+		/// <summary>
+		/// Builds an engine for the given graph (a snapshot is taken, so later changes to G are not seen)
+		/// </summary>
+		/// <param name="G">the graph to search</param>
+		BreadthFirstSearch(const Graph<N, E>& G) : BreadthFirstSearch(G.freeze())
+		{
+			// empty, on purpose
+		}
+
+
+		/// <summary>
+		/// Builds an engine for the given snapshot
+		/// </summary>
+		/// <param name="G">the graph to search</param>
+		BreadthFirstSearch(const CsrGraph<N, E>& G) : mGraph(G), mCurList(0), mAlpha(14.0), mBeta(24.0), mBottomUpSteps(0)
+		{
+			unsigned int num_nodes = mGraph.num_nodes();
+			unsigned int num_words = (num_nodes + 63) / 64;
+			for (unsigned int i = 0; i < num_words; i++)
+			{
+				mVisited.append(0);
+				mFrontierBits.append(0);
+				mNextBits.append(0);
+			}
+			for (unsigned int i = 0; i < num_nodes; i++)
+			{
+				mFrontierLists[0].append(0);
+				mFrontierLists[1].append(0);
+				mParents.append(-1);
+				mLevels.append(-1);
+			}
+			build_transpose();
+		}
+
+
+		/// <summary>
+		/// Gets the snapshot this engine searches (use it to convert between nodes and dense indices)
+		/// </summary>
+		/// <returns>the CsrGraph</returns>
+		const CsrGraph<N, E>& graph() const
+		{
+			return mGraph;
+		}
+
+
+		/// <summary>
+		/// Changes the direction-switching heuristics (the defaults, 14 and 24, are those suggested by Beamer et al.)
+		/// </summary>
+		/// <param name="alpha">go bottom-up when frontier edges > unexplored edges / alpha (0 = never go bottom-up)</param>
+		/// <param name="beta">go back to top-down when frontier size &lt; num_nodes / beta</param>
+		void set_heuristics(double alpha, double beta)
+		{
+			mAlpha = alpha;
+			mBeta = beta;
+		}
+
+
+		/// <summary>
+		/// Runs a search from the given node (raises a std::out_of_range exception if it is not in the graph).
+		/// The results replace those of any earlier run.
+		/// </summary>
+		/// <param name="start">the starting node</param>
+		/// <returns>the number of nodes reached (including start)</returns>
+		unsigned int run(const N& start)
+		{
+			int index = mGraph.index_of(start);
+			if (index < 0)
+				throw std::out_of_range("Invalid start node");
+			return run_index((unsigned int)index);
+		}
+
+
+		/// <summary>
+		/// Runs a search from the node with the given dense index
+		/// </summary>
+		/// <param name="start">the starting node's index in graph()</param>
+		/// <returns>the number of nodes reached (including start)</returns>
+		unsigned int run_index(unsigned int start)
+		{
+			unsigned int num_nodes = mGraph.num_nodes();
+			if (start >= num_nodes)
+				throw std::out_of_range("Invalid start index");
+			for (unsigned int i = 0; i < mVisited.size(); i++)
+				mVisited[i] = 0;
+			for (unsigned int i = 0; i < num_nodes; i++)
+			{
+				mParents[i] = -1;
+				mLevels[i] = -1;
+			}
+			mBottomUpSteps = 0;
+
+			set_bit(mVisited, start);
+			mParents[start] = start;
+			mLevels[start] = 0;
+			mCurList = 0;
+			mFrontierLists[mCurList][0] = start;
+			unsigned int frontier_size = 1;
+			unsigned int num_reached = 1;
+
+			// Edge counts used by the direction heuristic
+			unsigned long long frontier_edges = mGraph.degree(start);
+			unsigned long long unexplored_edges = mGraph.num_edges() - frontier_edges;
+
+			bool bottom_up = false;
+			int level = 0;
+			while (frontier_size > 0)
+			{
+				if (!bottom_up && mAlpha > 0 && frontier_edges > unexplored_edges / mAlpha)
+				{
+					bottom_up = true;
+					list_to_bits(frontier_size);
+				}
+				else if (bottom_up && frontier_size < num_nodes / mBeta)
+				{
+					bottom_up = false;
+					bits_to_list();
+				}
+
+				unsigned int next_size;
+				if (bottom_up)
+				{
+					next_size = bottom_up_step(level);
+					mBottomUpSteps++;
+				}
+				else
+					next_size = top_down_step(level, frontier_size);
+
+				// Update the edge counts (these loops only look at the new frontier)
+				frontier_edges = 0;
+				if (bottom_up)
+				{
+					for (unsigned int w = 0; w < mFrontierBits.size(); w++)
+					{
+						std::uint64_t word = mFrontierBits[w];
+						while (word)
+						{
+							unsigned int i = w * 64 + lowest_bit(word);
+							frontier_edges += mGraph.degree(i);
+							word &= word - 1;
+						}
+					}
+				}
+				else
+				{
+					for (unsigned int i = 0; i < next_size; i++)
+						frontier_edges += mGraph.degree(mFrontierLists[mCurList][i]);
+				}
+				unexplored_edges -= frontier_edges;
+				num_reached += next_size;
+				frontier_size = next_size;
+				level++;
+			}
+			return num_reached;
+		}
+
+
+		/// <summary>
+		/// Was the node with the given dense index reached by the last run?
+		/// </summary>
+		/// <param name="index">dense index</param>
+		/// <returns>true if it was reached</returns>
+		bool reached(unsigned int index) const
+		{
+			return mLevels[index] >= 0;
+		}
+
+
+		/// <summary>
+		/// Gets the traversal-tree parent of a node from the last run
+		/// </summary>
+		/// <param name="index">dense index</param>
+		/// <returns>the parent's dense index (-1 if not reached, index itself for the start node)</returns>
+		int parent(unsigned int index) const
+		{
+			return mParents[index];
+		}
+
+
+		/// <summary>
+		/// Gets the distance (in edges) of a node from the start of the last run
+		/// </summary>
+		/// <param name="index">dense index</param>
+		/// <returns>the number of edges from the start (-1 if not reached)</returns>
+		int level(unsigned int index) const
+		{
+			return mLevels[index];
+		}
+
+
+		/// <summary>
+		/// Gets all parents from the last run (indexed by dense index, -1 for nodes that were not reached)
+		/// </summary>
+		/// <returns>the parent list</returns>
+		const ArrayList<int>& parents() const
+		{
+			return mParents;
+		}
+
+
+		/// <summary>
+		/// Gets all levels from the last run (indexed by dense index, -1 for nodes that were not reached)
+		/// </summary>
+		/// <returns>the level list</returns>
+		const ArrayList<int>& levels() const
+		{
+			return mLevels;
+		}
+
+
+		/// <summary>
+		/// Converts the last run's traversal tree to node values (the start node is its own parent)
+		/// </summary>
+		/// <returns>a map of reached node => its parent</returns>
+		UnorderedMap<N, N> parent_map() const
+		{
+			UnorderedMap<N, N> result;
+			for (unsigned int i = 0; i < mParents.size(); i++)
+			{
+				if (mParents[i] >= 0)
+					result[mGraph.node_at(i)] = mGraph.node_at(mParents[i]);
+			}
+			return result;
+		}
+
+
+		/// <summary>
+		/// Returns how many levels of the last run were expanded bottom-up
+		/// </summary>
+		/// <returns>number of bottom-up steps</returns>
+		unsigned int num_bottom_up_steps() const
+		{
+			return mBottomUpSteps;
+		}
+
+	protected:
+		/// <summary>
+		/// Builds mInOffsets / mInSources from mGraph (a counting sort of the edges by destination)
+		/// </summary>
+		void build_transpose()
+		{
+			unsigned int num_nodes = mGraph.num_nodes();
+			for (unsigned int i = 0; i <= num_nodes; i++)
+				mInOffsets.append(0);
+			for (unsigned int e = 0; e < mGraph.num_edges(); e++)
+				mInOffsets[mGraph.target(e) + 1]++;
+			for (unsigned int i = 0; i < num_nodes; i++)
+				mInOffsets[i + 1] += mInOffsets[i];
+
+			ArrayList<unsigned int> fill_pos;
+			for (unsigned int i = 0; i < num_nodes; i++)
+				fill_pos.append(mInOffsets[i]);
+			for (unsigned int e = 0; e < mGraph.num_edges(); e++)
+				mInSources.append(0);
+
+			// Sources are visited in increasing order, so each node's in-list ends up sorted
+			for (unsigned int src = 0; src < num_nodes; src++)
+			{
+				for (unsigned int e = mGraph.edge_begin(src); e < mGraph.edge_end(src); e++)
+					mInSources[fill_pos[mGraph.target(e)]++] = src;
+			}
+		}
+
+
+		/// <summary>
+		/// Expands the current frontier list into the other list by checking the frontier's outgoing edges, and
+		/// then makes that list the current one.
+		/// </summary>
+		/// <param name="level">the level of the current frontier</param>
+		/// <param name="frontier_size">the number of nodes in the current frontier</param>
+		/// <returns>the size of the new frontier</returns>
+		unsigned int top_down_step(int level, unsigned int frontier_size)
+		{
+			// This is the hot loop, so it works on the raw arrays (every index here is valid by construction)
+			const unsigned int* frontier = mFrontierLists[mCurList].data();
+			unsigned int* next_frontier = mFrontierLists[1 - mCurList].data();
+			int* parents = mParents.data();
+			int* levels = mLevels.data();
+			unsigned int next_size = 0;
+			for (unsigned int f = 0; f < frontier_size; f++)
+			{
+				unsigned int cur = frontier[f];
+				for (unsigned int e = mGraph.edge_begin(cur); e < mGraph.edge_end(cur); e++)
+				{
+					unsigned int next = mGraph.target(e);
+					if (!test_bit(mVisited, next))
+					{
+						set_bit(mVisited, next);
+						parents[next] = cur;
+						levels[next] = level + 1;
+						next_frontier[next_size++] = next;
+					}
+					else if (levels[next] == level + 1 && (int)cur < parents[next])
+					{
+						// Keep the tree canonical (lowest-indexed parent)
+						parents[next] = cur;
+					}
+				}
+			}
+			mCurList = 1 - mCurList;
+			return next_size;
+		}
+
+
+		/// <summary>
+		/// Expands the frontier bitmap (mFrontierBits) into mNextBits by having every unvisited node look for
+		/// a parent in the frontier.  The result is swapped into mFrontierBits.
+		/// </summary>
+		/// <param name="level">the level of the current frontier</param>
+		/// <returns>the size of the new frontier</returns>
+		unsigned int bottom_up_step(int level)
+		{
+			unsigned int num_nodes = mGraph.num_nodes();
+			unsigned int next_size = 0;
+			for (unsigned int w = 0; w < mVisited.size(); w++)
+			{
+				mNextBits[w] = 0;
+				std::uint64_t unvisited = ~mVisited[w];
+				while (unvisited)
+				{
+					unsigned int node = w * 64 + lowest_bit(unvisited);
+					unvisited &= unvisited - 1;
+					if (node >= num_nodes)
+						break;
+					for (unsigned int e = mInOffsets[node]; e < mInOffsets[node + 1]; e++)
+					{
+						unsigned int src = mInSources[e];
+						if (test_bit(mFrontierBits, src))
+						{
+							mParents[node] = src;
+							mLevels[node] = level + 1;
+							mNextBits[w] |= (std::uint64_t)1 << (node & 63);
+							next_size++;
+							break;
+						}
+					}
+				}
+			}
+			// Newly-reached nodes are only marked visited now, so they can't act as parents in this same step
+			for (unsigned int w = 0; w < mVisited.size(); w++)
+			{
+				mVisited[w] |= mNextBits[w];
+				std::uint64_t temp = mFrontierBits[w];
+				mFrontierBits[w] = mNextBits[w];
+				mNextBits[w] = temp;
+			}
+			return next_size;
+		}
+
+
+		/// <summary>
+		/// Converts the frontier list to the frontier bitmap
+		/// </summary>
+		/// <param name="frontier_size">the number of nodes in the frontier list</param>
+		void list_to_bits(unsigned int frontier_size)
+		{
+			for (unsigned int w = 0; w < mFrontierBits.size(); w++)
+				mFrontierBits[w] = 0;
+			for (unsigned int i = 0; i < frontier_size; i++)
+				set_bit(mFrontierBits, mFrontierLists[mCurList][i]);
+		}
+
+
+		/// <summary>
+		/// Converts the frontier bitmap to the frontier list (in increasing index order)
+		/// </summary>
+		void bits_to_list()
+		{
+			unsigned int size = 0;
+			for (unsigned int w = 0; w < mFrontierBits.size(); w++)
+			{
+				std::uint64_t word = mFrontierBits[w];
+				while (word)
+				{
+					mFrontierLists[mCurList][size++] = w * 64 + lowest_bit(word);
+					word &= word - 1;
+				}
+			}
+		}
+
+
+		/// <summary>
+		/// Tests a bit in a bitmap
+		/// </summary>
+		static bool test_bit(const ArrayList<std::uint64_t>& bits, unsigned int index)
+		{
+			return (bits[index >> 6] >> (index & 63)) & 1;
+		}
+
+
+		/// <summary>
+		/// Sets a bit in a bitmap
+		/// </summary>
+		static void set_bit(ArrayList<std::uint64_t>& bits, unsigned int index)
+		{
+			bits[index >> 6] |= (std::uint64_t)1 << (index & 63);
+		}
+
+
+		/// <summary>
+		/// Returns the position of the lowest set bit in a (non-zero) word
+		/// </summary>
+		static unsigned int lowest_bit(std::uint64_t word)
+		{
+#if defined(_MSC_VER)
+			unsigned long pos;
+			_BitScanForward64(&pos, word);
+			return (unsigned int)pos;
+#else
+			return (unsigned int)__builtin_ctzll(word);
+#endif
+		}
+	};
+}
@@ -0,0 +1,330 @@
+#pragma once
+#include <graph.h>
+#include <csr_graph.h>
+#include <stdexcept>
+
+namespace ssuds
+{
+	/// <summary>
+	/// A re-usable, iterative depth-first search engine.  Rather than recursing once per node, the path
+	/// being explored is kept in an explicit array-based stack (one frame per node holding the next edge to
+	/// try), so paths of millions of nodes don't overflow the call stack.
+	///
+	/// Optional visitor callbacks are invoked when a node is discovered (pre-order) and when all of its
+	/// descendants are finished (post-order).  Each node also gets CLRS-style discovery / finish timestamps
+	/// (a single counter shared by both events), which is what topological sorting and strongly-connected
+	/// component algorithms build on.
+	/// </summary>
+	/// <typeparam name="N">The type of Nodes/Vertices</typeparam>
+	/// <typeparam name="E">The type of Edges</typeparam>
+	template <class N, class E>
+	class DepthFirstSearch
+	{
+	protected:
+		/// <summary>
+		/// The snapshot of the graph we're searching
+		/// </summary>
+		CsrGraph<N, E> mGraph;
+
+		/// <summary>
+		/// The traversal-tree parent of each node (-1 if not visited, the node itself for a root)
+		/// </summary>
+		ArrayList<int> mParents;
+
+		/// <summary>
+		/// When each node was discovered (-1 if not visited)
+		/// </summary>
+		ArrayList<int> mDiscovery;
+
+		/// <summary>
+		/// When each node was finished (-1 if not visited)
+		/// </summary>
+		ArrayList<int> mFinish;
+
+		/// <summary>
+		/// The node of each stack frame (only the first mStackSize entries are used)
+		/// </summary>
+		ArrayList<unsigned int> mNodeStack;
+
+		/// <summary>
+		/// The next edge to try for each stack frame (parallel to mNodeStack)
+		/// </summary>
+		ArrayList<unsigned int> mEdgeStack;
+
+		/// <summary>
+		/// The current depth of the stack
+		/// </summary>
+		unsigned int mStackSize;
+
+		/// <summary>
+		/// The next timestamp to hand out
+		/// </summary>
+		int mTime;
+
+	public:
+		/// <summary>
+		/// Builds an engine for the given graph (a snapshot is taken, so later changes to G are not seen)
+		/// </summary>
+		/// <param name="G">the graph to search</param>
+		DepthFirstSearch(const Graph<N, E>& G) : DepthFirstSearch(G.freeze())
+		{
+			// empty, on purpose
+		}
+
+
+		/// <summary>
+		/// Builds an engine for the given snapshot
+		/// </summary>
+		/// <param name="G">the graph to search</param>
+		DepthFirstSearch(const CsrGraph<N, E>& G) : mGraph(G), mStackSize(0), mTime(0)
+		{
+			for (unsigned int i = 0; i < mGraph.num_nodes(); i++)
+			{
+				mParents.append(-1);
+				mDiscovery.append(-1);
+				mFinish.append(-1);
+			}
+		}
+
+
+		/// <summary>
+		/// Gets the snapshot this engine searches (use it to convert between nodes and dense indices)
+		/// </summary>
+		/// <returns>the CsrGraph</returns>
+		const CsrGraph<N, E>& graph() const
+		{
+			return mGraph;
+		}
+
+
+		/// <summary>
+		/// Runs a search from the given node (raises a std::out_of_range exception if it is not in the graph).
+		/// The results replace those of any earlier run.
+		/// </summary>
+		/// <param name="start">the starting node</param>
+		/// <returns>the number of nodes visited (including start)</returns>
+		unsigned int run(const N& start)
+		{
+			return run(start, [](unsigned int) {}, [](unsigned int) {});
+		}
+
+
+		/// <summary>
+		/// Runs a search from the given node, calling pre_visit(index) as each node is discovered and
+		/// post_visit(index) as each node is finished (index is the node's dense index in graph()).
+		/// </summary>
+		/// <param name="start">the starting node</param>
+		/// <param name="pre_visit">pre-order callback</param>
+		/// <param name="post_visit">post-order callback</param>
+		/// <returns>the number of nodes visited (including start)</returns>
+		template <class Pre, class Post>
+		unsigned int run(const N& start, Pre pre_visit, Post post_visit)
+		{
+			int index = mGraph.index_of(start);
+			if (index < 0)
+				throw std::out_of_range("Invalid start node");
+			return run_index((unsigned int)index, pre_visit, post_visit);
+		}
+
+
+		/// <summary>
+		/// Runs a search from the node with the given dense index
+		/// </summary>
+		/// <param name="start">the starting node's index in graph()</param>
+		/// <returns>the number of nodes visited (including start)</returns>
+		unsigned int run_index(unsigned int start)
+		{
+			return run_index(start, [](unsigned int) {}, [](unsigned int) {});
+		}
+
+
+		/// <summary>
+		/// Runs a search (with callbacks) from the node with the given dense index
+		/// </summary>
+		/// <param name="start">the starting node's index in graph()</param>
+		/// <param name="pre_visit">pre-order callback</param>
+		/// <param name="post_visit">post-order callback</param>
+		/// <returns>the number of nodes visited (including start)</returns>
+		template <class Pre, class Post>
+		unsigned int run_index(unsigned int start, Pre pre_visit, Post post_visit)
+		{
+			if (start >= mGraph.num_nodes())
+				throw std::out_of_range("Invalid start index");
+			reset();
+			return visit_from(start, pre_visit, post_visit);
+		}
+
+
+		/// <summary>
+		/// Searches from every node that hasn't been visited yet (in dense-index order), producing a
+		/// depth-first forest that covers the whole graph
+		/// </summary>
+		/// <returns>the number of nodes visited (always num_nodes)</returns>
+		unsigned int run_all()
+		{
+			return run_all([](unsigned int) {}, [](unsigned int) {});
+		}
+
+
+		/// <summary>
+		/// Searches (with callbacks) from every node that hasn't been visited yet, in dense-index order
+		/// </summary>
+		/// <param name="pre_visit">pre-order callback</param>
+		/// <param name="post_visit">post-order callback</param>
+		/// <returns>the number of nodes visited (always num_nodes)</returns>
+		template <class Pre, class Post>
+		unsigned int run_all(Pre pre_visit, Post post_visit)
+		{
+			reset();
+			unsigned int count = 0;
+			for (unsigned int i = 0; i < mGraph.num_nodes(); i++)
+			{
+				if (mDiscovery[i] < 0)
+					count += visit_from(i, pre_visit, post_visit);
+			}
+			return count;
+		}
+
+
+		/// <summary>
+		/// Was the node with the given dense index visited by the last run?
+		/// </summary>
+		/// <param name="index">dense index</param>
+		/// <returns>true if it was visited</returns>
+		bool visited(unsigned int index) const
+		{
+			return mDiscovery[index] >= 0;
+		}
+
+
+		/// <summary>
+		/// Gets the traversal-tree parent of a node from the last run
+		/// </summary>
+		/// <param name="index">dense index</param>
+		/// <returns>the parent's dense index (-1 if not visited, index itself for a root)</returns>
+		int parent(unsigned int index) const
+		{
+			return mParents[index];
+		}
+
+
+		/// <summary>
+		/// Gets the time at which a node was discovered in the last run
+		/// </summary>
+		/// <param name="index">dense index</param>
+		/// <returns>the discovery timestamp (-1 if not visited)</returns>
+		int discovery_time(unsigned int index) const
+		{
+			return mDiscovery[index];
+		}
+
+
+		/// <summary>
+		/// Gets the time at which a node was finished (all descendants explored) in the last run
+		/// </summary>
+		/// <param name="index">dense index</param>
+		/// <returns>the finish timestamp (-1 if not visited)</returns>
+		int finish_time(unsigned int index) const
+		{
+			return mFinish[index];
+		}
+
+
+		/// <summary>
+		/// Converts the last run's traversal tree to node values (roots are their own parent)
+		/// </summary>
+		/// <returns>a map of visited node => its parent</returns>
+		UnorderedMap<N, N> parent_map() const
+		{
+			UnorderedMap<N, N> result;
+			for (unsigned int i = 0; i < mParents.size(); i++)
+			{
+				if (mParents[i] >= 0)
+					result[mGraph.node_at(i)] = mGraph.node_at(mParents[i]);
+			}
+			return result;
+		}
+
+	protected:
+		/// <summary>
+		/// Clears the results of the last run
+		/// </summary>
+		void reset()
+		{
+			for (unsigned int i = 0; i < mGraph.num_nodes(); i++)
+			{
+				mParents[i] = -1;
+				mDiscovery[i] = -1;
+				mFinish[i] = -1;
+			}
+			mTime = 0;
+			mStackSize = 0;
+		}
+
+
+		/// <summary>
+		/// Pushes a newly-discovered node on the stack
+		/// </summary>
+		/// <param name="node">the node's dense index</param>
+		/// <param name="parent">its parent's dense index</param>
+		template <class Pre>
+		void discover(unsigned int node, unsigned int parent, Pre& pre_visit)
+		{
+			mParents[node] = parent;
+			mDiscovery[node] = mTime++;
+			if (mStackSize < mNodeStack.size())
+			{
+				mNodeStack[mStackSize] = node;
+				mEdgeStack[mStackSize] = mGraph.edge_begin(node);
+			}
+			else
+			{
+				mNodeStack.append(node);
+				mEdgeStack.append(mGraph.edge_begin(node));
+			}
+			mStackSize++;
+			pre_visit(node);
+		}
+
+
+		/// <summary>
+		/// The main loop: explores everything reachable (and not yet visited) from start
+		/// </summary>
+		/// <param name="start">the root's dense index</param>
+		/// <param name="pre_visit">pre-order callback</param>
+		/// <param name="post_visit">post-order callback</param>
+		/// <returns>the number of nodes newly visited</returns>
+		template <class Pre, class Post>
+		unsigned int visit_from(unsigned int start, Pre& pre_visit, Post& post_visit)
+		{
+			unsigned int count = 1;
+			discover(start, start, pre_visit);
+			while (mStackSize > 0)
+			{
+				unsigned int top = mStackSize - 1;
+				unsigned int cur = mNodeStack[top];
+				unsigned int e = mEdgeStack[top];
+				unsigned int end = mGraph.edge_end(cur);
+
+				// Skip over neighbors that have already been visited
+				while (e < end && mDiscovery[mGraph.target(e)] >= 0)
+					e++;
+
+				if (e == end)
+				{
+					// Out of neighbors -- this node is finished
+					mFinish[cur] = mTime++;
+					mStackSize--;
+					post_visit(cur);
+				}
+				else
+				{
+					mEdgeStack[top] = e + 1;
+					discover(mGraph.target(e), cur, pre_visit);
+					count++;
+				}
+			}
+			return count;
+		}
+	};
+}
@@ -0,0 +1,336 @@
+#pragma once
+#include <graph.h>
+#include <csr_graph.h>
+#include <thread_pool.h>
+#include <atomic>
+#include <cstdint>
+#include <climits>
+#include <stdexcept>
+
+namespace ssuds
+{
+	/// <summary>
+	/// A multithreaded, level-synchronous breadth-first search engine.  Each level's frontier is cut into
+	/// chunks that are spread over a ThreadPool (whose workers steal chunks from each other when they run
+	/// out).  Nodes are claimed with atomic visited bits and every worker collects its discoveries in its own
+	/// buffer, so the only shared writes are single atomic operations.
+	///
+	/// The traversal tree is the same canonical tree produced by BreadthFirstSearch: every node's parent is
+	/// the lowest-indexed (in the CsrGraph) node of the previous level with an edge to it.  So the result
+	/// does not depend on the number of threads or on scheduling.
+	/// </summary>
+	/// <typeparam name="N">The type of Nodes/Vertices</typeparam>
+	/// <typeparam name="E">The type of Edges</typeparam>
+	template <class N, class E>
+	class ParallelBreadthFirstSearch
+	{
+	protected:
+		/// <summary>
+		/// The number of frontier nodes handled by one task
+		/// </summary>
+		static const unsigned int msChunkSize = 256;
+
+		/// <summary>
+		/// The snapshot of the graph we're searching
+		/// </summary>
+		CsrGraph<N, E> mGraph;
+
+		/// <summary>
+		/// The worker threads
+		/// </summary>
+		ThreadPool mPool;
+
+		/// <summary>
+		/// One bit per node: has it been claimed (added to a frontier)?
+		/// </summary>
+		std::atomic<std::uint64_t>* mVisited;
+
+		/// <summary>
+		/// The traversal-tree parent of each node (UINT_MAX if not reached)
+		/// </summary>
+		std::atomic<unsigned int>* mParents;
+
+		/// <summary>
+		/// The distance (in edges) of each node from the start (-1 if not reached)
+		/// </summary>
+		std::atomic<int>* mLevels;
+
+		/// <summary>
+		/// The current frontier (only the first frontier_size entries are used)
+		/// </summary>
+		ArrayList<unsigned int> mFrontier;
+
+		/// <summary>
+		/// One buffer per worker for the nodes it discovers during a level
+		/// </summary>
+		ArrayList<unsigned int>* mLocalNext;
+
+		/// <summary>
+		/// How many entries of each mLocalNext buffer are in use
+		/// </summary>
+		unsigned int* mLocalSizes;
+
+	public:
+		/// <summary>
+		/// Builds an engine for the given graph (a snapshot is taken, so later changes to G are not seen)
+		/// </summary>
+		/// <param name="G">the graph to search</param>
+		/// <param name="num_threads">the number of threads to use (0 = one per hardware thread)</param>
+		ParallelBreadthFirstSearch(const Graph<N, E>& G, unsigned int num_threads = 0) : ParallelBreadthFirstSearch(G.freeze(), num_threads)
+		{
+			// empty, on purpose
+		}
+
+
+		/// <summary>
+		/// Builds an engine for the given snapshot
+		/// </summary>
+		/// <param name="G">the graph to search</param>
+		/// <param name="num_threads">the number of threads to use (0 = one per hardware thread)</param>
+		ParallelBreadthFirstSearch(const CsrGraph<N, E>& G, unsigned int num_threads = 0) : mGraph(G), mPool(num_threads)
+		{
+			unsigned int num_nodes = mGraph.num_nodes();
+			unsigned int num_words = (num_nodes + 63) / 64;
+			mVisited = new std::atomic<std::uint64_t>[num_words > 0 ? num_words : 1];
+			mParents = new std::atomic<unsigned int>[num_nodes > 0 ? num_nodes : 1];
+			mLevels = new std::atomic<int>[num_nodes > 0 ? num_nodes : 1];
+			for (unsigned int i = 0; i < num_words; i++)
+				mVisited[i].store(0);
+			for (unsigned int i = 0; i < num_nodes; i++)
+			{
+				mParents[i].store(UINT_MAX);
+				mLevels[i].store(-1);
+				mFrontier.append(0);
+			}
+			mLocalNext = new ArrayList<unsigned int>[mPool.num_threads()];
+			mLocalSizes = new unsigned int[mPool.num_threads()];
+		}
+
+		/// An engine can't be copied
+		ParallelBreadthFirstSearch(const ParallelBreadthFirstSearch&) = delete;
+
+		/// An engine can't be copied
+		ParallelBreadthFirstSearch& operator=(const ParallelBreadthFirstSearch&) = delete;
+
+		/// Destructor
+		~ParallelBreadthFirstSearch()
+		{
+			delete[] mVisited;
+			delete[] mParents;
+			delete[] mLevels;
+			delete[] mLocalNext;
+			delete[] mLocalSizes;
+		}
+
+
+		/// <summary>
+		/// Gets the snapshot this engine searches (use it to convert between nodes and dense indices)
+		/// </summary>
+		/// <returns>the CsrGraph</returns>
+		const CsrGraph<N, E>& graph() const
+		{
+			return mGraph;
+		}
+
+
+		/// <summary>
+		/// Returns the number of threads used
+		/// </summary>
+		/// <returns>number of threads</returns>
+		unsigned int num_threads() const
+		{
+			return mPool.num_threads();
+		}
+
+
+		/// <summary>
+		/// Runs a search from the given node (raises a std::out_of_range exception if it is not in the graph).
+		/// The results replace those of any earlier run.
+		/// </summary>
+		/// <param name="start">the starting node</param>
+		/// <returns>the number of nodes reached (including start)</returns>
+		unsigned int run(const N& start)
+		{
+			int index = mGraph.index_of(start);
+			if (index < 0)
+				throw std::out_of_range("Invalid start node");
+			return run_index((unsigned int)index);
+		}
+
+
+		/// <summary>
+		/// Runs a search from the node with the given dense index
+		/// </summary>
+		/// <param name="start">the starting node's index in graph()</param>
+		/// <returns>the number of nodes reached (including start)</returns>
+		unsigned int run_index(unsigned int start)
+		{
+			unsigned int num_nodes = mGraph.num_nodes();
+			if (start >= num_nodes)
+				throw std::out_of_range("Invalid start index");
+
+			// Reset (in parallel -- this touches every node)
+			unsigned int num_words = (num_nodes + 63) / 64;
+			unsigned int reset_tasks = (num_words + msChunkSize - 1) / msChunkSize;
+			mPool.parallel_for(reset_tasks, [&](unsigned int task, unsigned int)
+			{
+				unsigned int first_word = task * msChunkSize;
+				unsigned int last_word = first_word + msChunkSize < num_words ? first_word + msChunkSize : num_words;
+				for (unsigned int w = first_word; w < last_word; w++)
+					mVisited[w].store(0, std::memory_order_relaxed);
+				unsigned int last_node = last_word * 64 < num_nodes ? last_word * 64 : num_nodes;
+				for (unsigned int i = first_word * 64; i < last_node; i++)
+				{
+					mParents[i].store(UINT_MAX, std::memory_order_relaxed);
+					mLevels[i].store(-1, std::memory_order_relaxed);
+				}
+			});
+
+			mVisited[start >> 6].store((std::uint64_t)1 << (start & 63));
+			mParents[start].store(start);
+			mLevels[start].store(0);
+			mFrontier[0] = start;
+			unsigned int frontier_size = 1;
+			unsigned int num_reached = 1;
+
+			int level = 0;
+			while (frontier_size > 0)
+			{
+				for (unsigned int w = 0; w < mPool.num_threads(); w++)
+					mLocalSizes[w] = 0;
+
+				unsigned int num_tasks = (frontier_size + msChunkSize - 1) / msChunkSize;
+				mPool.parallel_for(num_tasks, [&](unsigned int task, unsigned int worker)
+				{
+					unsigned int first = task * msChunkSize;
+					unsigned int last = first + msChunkSize < frontier_size ? first + msChunkSize : frontier_size;
+					for (unsigned int f = first; f < last; f++)
+						expand(mFrontier[f], level, worker);
+				});
+
+				// Gather the per-worker discoveries into the new frontier
+				frontier_size = 0;
+				for (unsigned int w = 0; w < mPool.num_threads(); w++)
+				{
+					for (unsigned int i = 0; i < mLocalSizes[w]; i++)
+						mFrontier[frontier_size++] = mLocalNext[w][i];
+				}
+				num_reached += frontier_size;
+				level++;
+			}
+			return num_reached;
+		}
+
+
+		/// <summary>
+		/// Was the node with the given dense index reached by the last run?
+		/// </summary>
+		/// <param name="index">dense index</param>
+		/// <returns>true if it was reached</returns>
+		bool reached(unsigned int index) const
+		{
+			return level(index) >= 0;
+		}
+
+
+		/// <summary>
+		/// Gets the traversal-tree parent of a node from the last run
+		/// </summary>
+		/// <param name="index">dense index</param>
+		/// <returns>the parent's dense index (-1 if not reached, index itself for the start node)</returns>
+		int parent(unsigned int index) const
+		{
+			if (index >= mGraph.num_nodes())
+				throw std::out_of_range("Invalid index: " + std::to_string(index));
+			unsigned int p = mParents[index].load();
+			return p == UINT_MAX ? -1 : (int)p;
+		}
+
+
+		/// <summary>
+		/// Gets the distance (in edges) of a node from the start of the last run
+		/// </summary>
+		/// <param name="index">dense index</param>
+		/// <returns>the number of edges from the start (-1 if not reached)</returns>
+		int level(unsigned int index) const
+		{
+			if (index >= mGraph.num_nodes())
+				throw std::out_of_range("Invalid index: " + std::to_string(index));
+			return mLevels[index].load();
+		}
+
+
+		/// <summary>
+		/// Gets all parents from the last run (indexed by dense index, -1 for nodes that were not reached)
+		/// </summary>
+		/// <returns>the parent list</returns>
+		ArrayList<int> parents() const
+		{
+			ArrayList<int> result;
+			for (unsigned int i = 0; i < mGraph.num_nodes(); i++)
+				result.append(parent(i));
+			return result;
+		}
+
+
+		/// <summary>
+		/// Converts the last run's traversal tree to node values (the start node is its own parent)
+		/// </summary>
+		/// <returns>a map of reached node => its parent</returns>
+		UnorderedMap<N, N> parent_map() const
+		{
+			UnorderedMap<N, N> result;
+			for (unsigned int i = 0; i < mGraph.num_nodes(); i++)
+			{
+				int p = parent(i);
+				if (p >= 0)
+					result[mGraph.node_at(i)] = mGraph.node_at(p);
+			}
+			return result;
+		}
+
+	protected:
+		/// <summary>
+		/// Checks the outgoing edges of one frontier node (called concurrently by the workers)
+		/// </summary>
+		/// <param name="cur">the frontier node</param>
+		/// <param name="level">the level of the frontier</param>
+		/// <param name="worker">the worker running this (selects the discovery buffer)</param>
+		void expand(unsigned int cur, int level, unsigned int worker)
+		{
+			for (unsigned int e = mGraph.edge_begin(cur); e < mGraph.edge_end(cur); e++)
+			{
+				unsigned int next = mGraph.target(e);
+				std::uint64_t bit = (std::uint64_t)1 << (next & 63);
+				std::atomic<std::uint64_t>& word = mVisited[next >> 6];
+
+				// Nodes from earlier levels are final.  (Nodes claimed during *this* level may not have
+				// their level stored yet, which is why -1 also counts as "this level")
+				if (word.load(std::memory_order_relaxed) & bit)
+				{
+					int next_level = mLevels[next].load(std::memory_order_relaxed);
+					if (next_level != -1 && next_level <= level)
+						continue;
+				}
+
+				// Keep the lowest-indexed parent (an atomic "min")
+				unsigned int old_parent = mParents[next].load(std::memory_order_relaxed);
+				while (cur < old_parent && !mParents[next].compare_exchange_weak(old_parent, cur, std::memory_order_relaxed))
+				{
+					// old_parent was refreshed by the failed exchange -- try again
+				}
+
+				// Whoever sets the visited bit adds the node to the next frontier
+				if (!(word.fetch_or(bit, std::memory_order_relaxed) & bit))
+				{
+					mLevels[next].store(level + 1, std::memory_order_relaxed);
+					if (mLocalSizes[worker] < mLocalNext[worker].size())
+						mLocalNext[worker][mLocalSizes[worker]] = next;
+					else
+						mLocalNext[worker].append(next);
+					mLocalSizes[worker]++;
+				}
+			}
+		}
+	};
+}
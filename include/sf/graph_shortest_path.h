@@ -0,0 +1,241 @@
+#pragma once
+#include <graph.h>
+#include <priority_queue.h>
+#include <stdexcept>
+
+namespace ssuds
+{
+	/// <summary>
+	/// The result of a shortest-path search: the distance to every node that was settled plus the
+	/// predecessor of each node on its shortest path (which can be followed back to the source)
+	/// </summary>
+	/// <typeparam name="N">The type of Nodes/Vertices</typeparam>
+	/// <typeparam name="E">The type of Edges (the distances)</typeparam>
+	template <class N, class E>
+	class ShortestPaths
+	{
+	protected:
+		/// <summary>
+		/// The node the search started at
+		/// </summary>
+		N mSource;
+
+		/// <summary>
+		/// Shortest distance from the source to each reached node
+		/// </summary>
+		UnorderedMap<N, E> mDistances;
+
+		/// <summary>
+		/// The node before each reached node on its shortest path (the source has no entry)
+		/// </summary>
+		UnorderedMap<N, N> mPredecessors;
+
+	public:
+		/// <summary>
+		/// Constructor (used by shortest_path)
+		/// </summary>
+		/// <param name="source">the starting node</param>
+		ShortestPaths(const N& source) : mSource(source)
+		{
+			// empty, on purpose
+		}
+
+
+		/// <summary>
+		/// Returns true if a path to the given node was found
+		/// </summary>
+		/// <param name="node">the node in question</param>
+		/// <returns>true if the node was reached</returns>
+		bool reached(const N& node) const
+		{
+			return mDistances.find(node) != mDistances.end();
+		}
+
+
+		/// <summary>
+		/// Gets the length of the shortest path to a node (raises a std::out_of_range exception if it wasn't reached)
+		/// </summary>
+		/// <param name="node">the node in question</param>
+		/// <returns>the shortest distance from the source</returns>
+		const E& distance(const N& node) const
+		{
+			typename UnorderedMap<N, E>::UnorderedMapIterator it = mDistances.find(node);
+			if (it == mDistances.end())
+				throw std::out_of_range("That node was not reached");
+			return (*it).second;
+		}
+
+
+		/// <summary>
+		/// Follows the predecessor chain to build the path from the source to a node
+		/// </summary>
+		/// <param name="node">the destination</param>
+		/// <returns>the nodes on the path (source first, node last) or an empty list if it wasn't reached</returns>
+		ArrayList<N> path_to(const N& node) const
+		{
+			ArrayList<N> reversed;
+			if (!reached(node))
+				return reversed;
+			N cur = node;
+			reversed.append(cur);
+			typename UnorderedMap<N, N>::UnorderedMapIterator it = mPredecessors.find(cur);
+			while (it != mPredecessors.end())
+			{
+				cur = (*it).second;
+				reversed.append(cur);
+				it = mPredecessors.find(cur);
+			}
+
+			ArrayList<N> result;
+			for (unsigned int i = reversed.size(); i > 0; i--)
+				result.append(reversed[i - 1]);
+			return result;
+		}
+
+
+		/// <summary>
+		/// Gets the distance map (node => shortest distance) for every reached node
+		/// </summary>
+		/// <returns>the distance map</returns>
+		const UnorderedMap<N, E>& distances() const
+		{
+			return mDistances;
+		}
+
+
+		/// <summary>
+		/// Gets the predecessor map (node => previous node on its shortest path) for every reached node but the source
+		/// </summary>
+		/// <returns>the predecessor map</returns>
+		const UnorderedMap<N, N>& predecessors() const
+		{
+			return mPredecessors;
+		}
+
+
+		/// <summary>
+		/// The node the search started at
+		/// </summary>
+		/// <returns>the source node</returns>
+		const N& source() const
+		{
+			return mSource;
+		}
+
+		/// <summary>
+		/// Gives _shortest_path write access to our maps
+		/// </summary>
+		template <unsigned int D, class N2, class E2, class H>
+		friend ShortestPaths<N2, E2> _shortest_path(const Graph<N2, E2>& G, const N2& src, const N2* dst, H heuristic);
+	};
+
+
+	/// <summary>
+	/// The internal support method for all shortest_path variations: A* search (which is Dijkstra's algorithm
+	/// when the heuristic is always zero) using a d-ary PriorityQueue with lazy deletion.
+	/// </summary>
+	/// <typeparam name="D">The arity of the heap</typeparam>
+	/// <param name="G">the graph (all edge values must be non-negative)</param>
+	/// <param name="src">the starting node</param>
+	/// <param name="dst">the destination (the search stops once it is settled) or nullptr to find the paths to all nodes</param>
+	/// <param name="heuristic">an estimate of the remaining distance to dst</param>
+	/// <returns>the search results</returns>
+	template <unsigned int D, class N, class E, class H>
+	ShortestPaths<N, E> _shortest_path(const Graph<N, E>& G, const N& src, const N* dst, H heuristic)
+	{
+		if (!G.contains_node(src))
+			throw std::out_of_range("Invalid source node");
+
+		ShortestPaths<N, E> result(src);
+		// Distances / predecessors of nodes that have been reached but not settled yet.  A node is only
+		// copied into result (which, as a side effect, marks it settled) once its distance is final, so an
+		// early exit at dst never reports a frontier node's tentative distance.
+		UnorderedMap<N, E> tentative;
+		UnorderedMap<N, N> tentative_pred;
+		PriorityQueue<N, E, D> open;
+		tentative[src] = E();
+		open.push(src, heuristic(src));
+
+		while (!open.empty())
+		{
+			N cur = open.pop();
+			if (result.mDistances.find(cur) != result.mDistances.end())
+				continue;				// a stale (lazily-deleted) entry
+			E cur_dist = tentative[cur];
+			result.mDistances[cur] = cur_dist;
+			typename UnorderedMap<N, N>::UnorderedMapIterator pred_it = tentative_pred.find(cur);
+			if (pred_it != tentative_pred.end())
+				result.mPredecessors[cur] = (*pred_it).second;
+			if (dst && cur == *dst)
+				break;
+
+			typename UnorderedMap<N, UnorderedMap<N, E>>::UnorderedMapIterator it = G.find(cur);
+			typename UnorderedMap<N, E>::UnorderedMapIterator inner_it = (*it).second.begin();
+			while (inner_it != (*it).second.end())
+			{
+				const N& next = (*inner_it).first;
+				if (result.mDistances.find(next) == result.mDistances.end())
+				{
+					E new_dist = cur_dist + (*inner_it).second;
+					typename UnorderedMap<N, E>::UnorderedMapIterator dist_it = tentative.find(next);
+					if (dist_it == tentative.end() || new_dist < (*dist_it).second)
+					{
+						tentative[next] = new_dist;
+						tentative_pred[next] = cur;
+						open.push(next, new_dist + heuristic(next));
+					}
+				}
+				++inner_it;
+			}
+		}
+		return result;
+	}
+
+
+	/// <summary>
+	/// Finds the shortest path between two nodes using A* search.  The heuristic must never over-estimate
+	/// the remaining distance and must be consistent (h(a) &lt;= weight(a, b) + h(b)) for the result to be optimal.
+	/// Usage: shortest_path(G, a, b, [](const int&amp; n) { return estimate_from(n); })
+	///    or: shortest_path&lt;4&gt;(G, a, b, ...) to use a 4-ary heap
+	/// </summary>
+	/// <typeparam name="D">The arity of the internal heap (default 2)</typeparam>
+	/// <param name="G">the graph (all edge values must be non-negative)</param>
+	/// <param name="src">the starting node (a std::out_of_range exception is raised if it isn't in G)</param>
+	/// <param name="dst">the destination node</param>
+	/// <param name="heuristic">callable taking a node and returning an E estimate of its distance to dst</param>
+	/// <returns>the search results (call path_to(dst) for the path)</returns>
+	template <unsigned int D = 2, class N, class E, class H>
+	ShortestPaths<N, E> shortest_path(const Graph<N, E>& G, const N& src, const N& dst, H heuristic)
+	{
+		return _shortest_path<D>(G, src, &dst, heuristic);
+	}
+
+
+	/// <summary>
+	/// Finds the shortest path between two nodes using Dijkstra's algorithm
+	/// </summary>
+	/// <typeparam name="D">The arity of the internal heap (default 2)</typeparam>
+	/// <param name="G">the graph (all edge values must be non-negative)</param>
+	/// <param name="src">the starting node (a std::out_of_range exception is raised if it isn't in G)</param>
+	/// <param name="dst">the destination node</param>
+	/// <returns>the search results (call path_to(dst) for the path)</returns>
+	template <unsigned int D = 2, class N, class E>
+	ShortestPaths<N, E> shortest_path(const Graph<N, E>& G, const N& src, const N& dst)
+	{
+		return _shortest_path<D>(G, src, &dst, [](const N&) { return E(); });
+	}
+
+
+	/// <summary>
+	/// Finds the shortest paths from a node to every reachable node using Dijkstra's algorithm
+	/// </summary>
+	/// <typeparam name="D">The arity of the internal heap (default 2)</typeparam>
+	/// <param name="G">the graph (all edge values must be non-negative)</param>
+	/// <param name="src">the starting node (a std::out_of_range exception is raised if it isn't in G)</param>
+	/// <returns>the search results</returns>
+	template <unsigned int D = 2, class N, class E>
+	ShortestPaths<N, E> shortest_path(const Graph<N, E>& G, const N& src)
+	{
+		return _shortest_path<D>(G, src, (const N*)nullptr, [](const N&) { return E(); });
+	}
+}
@@ -1,55 +1,187 @@
 #pragma once
 #include <string>
 #include <ostream>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+#include <initializer_list>
+#include <stdexcept>
+#include <new>
+#include <cstddef>
+#include <iterator>
 
 // Note: in C++, a general tempate (like this one) must be defined inline
 // entirely in the .h file (no .cpp files).  So, in this lab, array_list.cpp
 // contents are moved here
 
+// ArrayList::operator[] checks its index (throwing a std::out_of_range exception) in debug builds and skips
+// the check in release builds (NDEBUG defined, _DEBUG not).  Unchecked indexing is just a pointer offset, so
+// loops over it can be optimized (and vectorized) like loops over a plain array.  at() always checks.  To
+// override the default, define SSUDS_CHECKED_ACCESS as 0 or 1 for the WHOLE project (in its preprocessor
+// definitions) -- never per source file, since every file must see the same operator[].
+#ifndef SSUDS_CHECKED_ACCESS
+#if defined(NDEBUG) && !defined(_DEBUG)
+#define SSUDS_CHECKED_ACCESS 0
+#else
+#define SSUDS_CHECKED_ACCESS 1
+#endif
+#endif
+
 namespace ssuds
 {
 	// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-	// @ ENUM CLASSES                           @
+	// @ GROWTH POLICIES                        @
 	// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
-	enum class ArrayListIteratorType { forward, backwards };
+	// A growth policy decides how an ArrayList's capacity changes.  It needs two static methods:
+	//    unsigned int grow(unsigned int capacity)                      -- the new capacity for a full list (> capacity)
+	//    unsigned int shrink(unsigned int size, unsigned int capacity) -- the new capacity after a removal (return
+	//                                                                     capacity to leave the array alone)
+
+	/// The default policy: start with 5 slots, double when full, and halve when less than half full (down to 5)
+	struct DoublingGrowthPolicy
+	{
+		static unsigned int grow(unsigned int capacity)
+		{
+			return capacity == 0 ? 5 : capacity * 2;
+		}
+
+		static unsigned int shrink(unsigned int size, unsigned int capacity)
+		{
+			return size < capacity / 2 && capacity >= 10 ? capacity / 2 : capacity;
+		}
+	};
 
-	/// An ArrayList is an array-based data structure. 
+
+	/// Grows by 1.5x (less wasted space than doubling, at the cost of a few more re-allocations) and
+	/// shrinks by a third when less than half full
+	struct OneAndAHalfGrowthPolicy
+	{
+		static unsigned int grow(unsigned int capacity)
+		{
+			return capacity < 5 ? 5 : capacity + capacity / 2;
+		}
+
+		static unsigned int shrink(unsigned int size, unsigned int capacity)
+		{
+			return size < capacity / 2 && capacity >= 10 ? capacity - capacity / 3 : capacity;
+		}
+	};
+
+
+	/// Doubles when full and never gives memory back (call shrink_to_fit to do that by hand)
+	struct NoShrinkGrowthPolicy
+	{
+		static unsigned int grow(unsigned int capacity)
+		{
+			return capacity == 0 ? 5 : capacity * 2;
+		}
+
+		static unsigned int shrink(unsigned int /*size*/, unsigned int capacity)
+		{
+			return capacity;
+		}
+	};
+
+
+	/// Doubles when full, but only halves once the list is less than a quarter full.  After either change the
+	/// list is half full, so a size that bounces around a power of two can't make it re-allocate over and over
+	struct HysteresisGrowthPolicy
+	{
+		static unsigned int grow(unsigned int capacity)
+		{
+			return capacity == 0 ? 5 : capacity * 2;
+		}
+
+		static unsigned int shrink(unsigned int size, unsigned int capacity)
+		{
+			return size < capacity / 4 && capacity >= 10 ? capacity / 2 : capacity;
+		}
+	};
+
+
+	/// Raises the exception for a bad ArrayList index.  Kept out of line so the (rarely-taken) check
+	/// in operator[] stays small enough to inline
+	inline void _throw_index_error(unsigned int index)
+	{
+		throw std::out_of_range("Invalid index: " + std::to_string(index));
+	}
+
+
+	/// Storage for the elements of a SmallArrayList that live inside the list object itself
+	template <class T, unsigned int N>
+	class _ArrayListInlineBuffer
+	{
+	protected:
+		/// Raw space for N elements
+		alignas(T) unsigned char mInlineBytes[sizeof(T) * N];
+
+		/// The inline slots (as T's)
+		T* inline_data()
+		{
+			return reinterpret_cast<T*>(mInlineBytes);
+		}
+	};
+
+
+	/// A regular ArrayList has no inline storage (and, being empty, this base takes no space)
 	template <class T>
-	class ArrayList
+	class _ArrayListInlineBuffer<T, 0>
+	{
+	protected:
+		/// There are no inline slots
+		T* inline_data()
+		{
+			return nullptr;
+		}
+	};
+
+
+	/// An ArrayList is an array-based data structure.
+	/// GrowthPolicy controls how the capacity grows and shrinks (see the policies above).  If
+	/// InlineCapacity is above 0, that many elements are stored inside the ArrayList object itself and the
+	/// heap is only used once it grows beyond that (see SmallArrayList)
+	template <class T, class GrowthPolicy = DoublingGrowthPolicy, unsigned int InlineCapacity = 0>
+	class ArrayList : protected _ArrayListInlineBuffer<T, InlineCapacity>
 	{
 	// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 	// @ NESTED CLASSES                         @
 	// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 	public:
 		/// <summary>
-		///  This is a forward/backwards iterator to traverse the values in an ArrayList
+		///  This is a random-access iterator to traverse the values in an ArrayList.  Since the elements are
+		///  contiguous it is just a pointer to the current element, so it works with the STL algorithms
+		///  (std::sort, std::lower_bound, ...) and costs nothing over indexing a plain array.  It is invalidated
+		///  by anything that changes the ArrayList's capacity.
 		/// </summary>
 		class ArrayListIterator
 		{
+		public:
+			typedef std::random_access_iterator_tag iterator_category;
+			typedef T value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef T* pointer;
+			typedef T& reference;
+
 		protected:
 			/// <summary>
-			/// A pointer to the controlling array list
+			///  The current element
 			/// </summary>
-			const ArrayList* mArrayList;
+			T* mPtr;
 
+		public:
 			/// <summary>
-			///  The current position / index in our traversal
+			///  The default constructor (a singular iterator, as required by the STL)
 			/// </summary>
-			int mPosition;
+			ArrayListIterator() : mPtr(nullptr)
+			{
+				// intentionally empty
+			}
 
 			/// <summary>
-			/// The type of traversal we're doing (forward or backwards)
+			///  The constructor (called indirectly by begin and end in the ArrayList)
 			/// </summary>
-			ArrayListIteratorType mType;
-
-		public:
-			/// <summary>
-			///  The constructor (called indirectly by begin and rbegin in the ArrayList)
-			/// </summary>
-			/// <param name="arr">The array we're traversing</param>
-			/// <param name="tp">The type of traversal to do</param>
-			/// <param name="start_index">The starting index</param>
-			ArrayListIterator(const ArrayList* arr, ArrayListIteratorType tp, int start_index) : mArrayList(arr), mPosition(start_index), mType(tp)
+			/// <param name="ptr">The element to point at</param>
+			explicit ArrayListIterator(T* ptr) : mPtr(ptr)
 			{
 				// intentionally empty
 			}
@@ -57,59 +189,157 @@ namespace ssuds
 			/// Comparison with another iterator
 			bool operator==(const ArrayListIterator& other) const
 			{
-				return mArrayList == other.mArrayList && mPosition == other.mPosition && mType == other.mType;
+				return mPtr == other.mPtr;
 			}
 
 			/// Not-comparison with another iterator
 			bool operator!=(const ArrayListIterator& other) const
 			{
-				return mArrayList != other.mArrayList || mPosition != other.mPosition || mType != other.mType;
+				return mPtr != other.mPtr;
+			}
+
+			/// Ordering comparisons (both iterators must be over the same ArrayList)
+			bool operator<(const ArrayListIterator& other) const
+			{
+				return mPtr < other.mPtr;
+			}
+
+			bool operator>(const ArrayListIterator& other) const
+			{
+				return mPtr > other.mPtr;
+			}
+
+			bool operator<=(const ArrayListIterator& other) const
+			{
+				return mPtr <= other.mPtr;
+			}
+
+			bool operator>=(const ArrayListIterator& other) const
+			{
+				return mPtr >= other.mPtr;
 			}
 
 			/// <summary>
 			/// Advance operator.  Called by doing ++it
 			/// </summary>
-			void operator++()
+			ArrayListIterator& operator++()
 			{
-				if (mType == ArrayListIteratorType::forward)
-					++mPosition;
-				else
-					--mPosition;
+				++mPtr;
+				return *this;
 			}
 
 			/// <summary>
 			/// Advance operator.  Called by doing it++
 			/// </summary>
-			/// <param name=""></param>
-			void operator++(int)
+			ArrayListIterator operator++(int)
+			{
+				ArrayListIterator result = *this;
+				++mPtr;
+				return result;
+			}
+
+			/// <summary>
+			/// Back-up operator.  Called by doing --it
+			/// </summary>
+			ArrayListIterator& operator--()
+			{
+				--mPtr;
+				return *this;
+			}
+
+			/// <summary>
+			/// Back-up operator.  Called by doing it--
+			/// </summary>
+			ArrayListIterator operator--(int)
+			{
+				ArrayListIterator result = *this;
+				--mPtr;
+				return result;
+			}
+
+			/// Moves this iterator amount elements
+			ArrayListIterator& operator+=(difference_type amount)
+			{
+				mPtr += amount;
+				return *this;
+			}
+
+			/// Moves this iterator amount elements back
+			ArrayListIterator& operator-=(difference_type amount)
+			{
+				mPtr -= amount;
+				return *this;
+			}
+
+			/// Creates an iterator amount elements after this one
+			ArrayListIterator operator+(difference_type amount) const
 			{
-				return ++(*this);
+				return ArrayListIterator(mPtr + amount);
+			}
+
+			/// Creates an iterator amount elements after it
+			friend ArrayListIterator operator+(difference_type amount, const ArrayListIterator& it)
+			{
+				return ArrayListIterator(it.mPtr + amount);
+			}
+
+			/// Creates an iterator amount elements before this one
+			ArrayListIterator operator-(difference_type amount) const
+			{
+				return ArrayListIterator(mPtr - amount);
+			}
+
+			/// The number of elements between two iterators
+			difference_type operator-(const ArrayListIterator& other) const
+			{
+				return mPtr - other.mPtr;
 			}
 
 			/// <summary>
 			///  De-reference style operator
 			/// </summary>
 			/// <returns>A reference to the value at the current spot</returns>
-			T& operator*()
+			T& operator*() const
+			{
+				return *mPtr;
+			}
+
+			/// Member access on the current value
+			T* operator->() const
 			{
-				return (*mArrayList)[mPosition];
+				return mPtr;
+			}
+
+			/// Gets the value offset elements away
+			T& operator[](difference_type offset) const
+			{
+				return mPtr[offset];
 			}
 		};
 
+		/// <summary>
+		///  The iterator returned by rbegin / rend, which goes from the last value to the first
+		/// </summary>
+		typedef std::reverse_iterator<ArrayListIterator> ArrayListReverseIterator;
+
+		/// STL-style names for the types above
+		typedef T value_type;
+		typedef ArrayListIterator iterator;
+		typedef ArrayListReverseIterator reverse_iterator;
+
 	// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 	// @ ATTRIBUTES                              @
 	// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 	protected:
-		/// The default (and minimum) capacity of an ArrayList
-		static const int msMinCapacity = 5;
-
 		/// The current number of "slots" AVAILABLE in mData (i.e. the array size)
 		unsigned int mCapacity;
 
 		/// How many slots are we USING?  This will always be less than or equal to mCapacity
 		unsigned int mSize;
 
-		/// The array of data we're currently holding
+		/// The array of data we're currently holding.  This is raw (uninitialized) memory for mCapacity
+		/// elements: only the first mSize slots hold constructed objects, so spare slots cost nothing
+		/// and T doesn't need a default constructor
 		T* mData;
 
 
@@ -124,7 +354,7 @@ namespace ssuds
 	/// <param name="os">an ostream object (ofstream, stringstream, cout, etc.) </param>
 	/// <param name="alist">the ArrayList</param>
 	/// <returns>the (possibly modified) os that was given to us</returns>
-	friend std::ostream& operator <<(std::ostream& os, const ArrayList<T>& alist)
+	friend std::ostream& operator <<(std::ostream& os, const ArrayList& alist)
 	{
 		os << "[";
 		for (unsigned int i = 0; i < alist.size(); i++)
@@ -138,27 +368,51 @@ namespace ssuds
 	}
 
 	/// <summary>
-	/// Gets the data item at the given index.  This will throw an std::out_of_bounds exception if index is invalid (less than 0 or >= size)
+	/// Gets the data item at the given index.  This will throw an std::out_of_bounds exception if index is invalid (less than 0 or >= size),
+	/// unless SSUDS_CHECKED_ACCESS is 0 (in which case an invalid index is undefined behavior)
 	/// </summary>
 	/// <param name="index">the index of the thing to return</param>
 	/// <returns>a reference to the value at the given index</returns>
 	T& operator[](unsigned int index) const
 	{
+#if SSUDS_CHECKED_ACCESS
 		if (index >= mSize)
-			throw std::out_of_range("Invalid index: " + std::to_string(index));
-
+			_throw_index_error(index);
+#endif
 		return mData[index];
 	}
 
 
-	ArrayList<T>& operator= (const ArrayList<T>& other)
+	/// <summary>
+	/// Makes us a (deep) copy of other.  Assigning a list to itself does nothing
+	/// </summary>
+	/// <param name="other">the list to copy</param>
+	/// <returns>a reference to us</returns>
+	ArrayList& operator= (const ArrayList& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			reallocate(other.mCapacity);
+			copy_construct(mData, other.mData, other.mSize);
+			mSize = other.mSize;
+		}
+		return *this;
+	}
+
+
+	/// <summary>
+	/// Takes over other's array (other is left empty)
+	/// </summary>
+	/// <param name="other">the soon-to-be-destroyed list</param>
+	/// <returns>a reference to us</returns>
+	ArrayList& operator= (ArrayList&& other)
 	{
-		clear();
-		mData = new T[other.mCapacity];
-		for (unsigned int i = 0; i < other.mSize; i++)
-			mData[i] = other[i];
-		mCapacity = other.mCapacity;
-		mSize = other.mSize;
+		if (this != &other)
+		{
+			clear();
+			take(other);
+		}
 		return *this;
 	}
 
@@ -168,41 +422,41 @@ namespace ssuds
 	// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 	public:
 		/// Default constructor
-		ArrayList() : mSize(0), mCapacity(0), mData(nullptr)
+		ArrayList() : mCapacity(InlineCapacity), mSize(0)
 		{
-			// intentionally empty
+			mData = this->inline_data();
 		};
 
 		/// Copy-constructor
-		ArrayList(const ArrayList& other) : mCapacity(other.mCapacity), mSize(other.mSize)
+		ArrayList(const ArrayList& other) : mCapacity(InlineCapacity), mSize(0)
 		{
-			mData = new T[mCapacity];
-			for (unsigned int i = 0; i < other.size(); i++)
-				mData[i] = other[i];
+			mData = this->inline_data();
+			reallocate(other.mCapacity);
+			copy_construct(mData, other.mData, other.mSize);
+			mSize = other.mSize;
 		}
 
 		/// Move-constructor: "steals" the data (shallow copy) from a soon-to-be-destroyed other ArrayList
-		ArrayList(ArrayList&& other) : mCapacity(other.mCapacity), mSize(other.mSize), mData(other.mData)
+		/// (elements in other's inline storage have to be moved over one by one)
+		ArrayList(ArrayList&& other) : mCapacity(InlineCapacity), mSize(0)
 		{
-			other.mData = NULL;
-			other.mCapacity = 0;
-			other.mSize = 0;
+			mData = this->inline_data();
+			take(other);
 		}
 
 		/// Initializer-list constructor
-		ArrayList(std::initializer_list<T> ilist) : mCapacity((int)ilist.size()), mSize((int)ilist.size())
+		ArrayList(std::initializer_list<T> ilist) : mCapacity(InlineCapacity), mSize(0)
 		{
-			mData = new T[mCapacity];
-			int i = 0;
-			for (T val : ilist)
-				mData[i++] = val;
+			mData = this->inline_data();
+			reallocate((unsigned int)ilist.size());
+			copy_construct(mData, ilist.begin(), (unsigned int)ilist.size());
+			mSize = (unsigned int)ilist.size();
 		}
 
 		/// Destructor
 		~ArrayList() 
 		{
-			if (mData)
-				delete[] mData;
+			clear();
 		}
 
 
@@ -211,17 +465,36 @@ namespace ssuds
 	// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 	public:
 		/// <summary>
-		///  Inserts a new element at the end of the array
+		///  Inserts a (copy of a) new element at the end of the array
 		/// </summary>
 		/// <param name="val">the new value to add</param>
-		void append(const T val)
+		void append(const T& val)
 		{
-			// check to see if we need to increase our capacity
-			grow();
+			emplace_back(val);
+		}
 
-			// Stick our new element in the last slot and (sneakily) increase our size in the process
-			mData[mSize] = val;
-			mSize++;
+
+		/// <summary>
+		///  Moves a new element to the end of the array
+		/// </summary>
+		/// <param name="val">the new value to add (it is moved-from afterwards)</param>
+		void append(T&& val)
+		{
+			emplace_back(std::move(val));
+		}
+
+
+		/// <summary>
+		/// Gets the data item at the given index, always checking it (a std::out_of_range exception
+		/// is thrown if index >= size), whatever SSUDS_CHECKED_ACCESS is set to
+		/// </summary>
+		/// <param name="index">the index of the thing to return</param>
+		/// <returns>a reference to the value at the given index</returns>
+		T& at(unsigned int index) const
+		{
+			if (index >= mSize)
+				_throw_index_error(index);
+			return mData[index];
 		}
 
 
@@ -231,7 +504,35 @@ namespace ssuds
 		/// <returns>a forward iterator</returns>
 		ArrayListIterator begin() const
 		{
-			return ArrayListIterator(this, ArrayListIteratorType::forward, 0);
+			return ArrayListIterator(mData);
+		}
+
+
+		/// <summary>
+		/// Builds a new element (from the given constructor arguments) at the end of the array
+		/// </summary>
+		/// <param name="args">the arguments to pass to T's constructor</param>
+		/// <returns>a reference to the new element</returns>
+		template <class... Args>
+		T& emplace_back(Args&&... args)
+		{
+			if (mSize == mCapacity)
+			{
+				// Build the new element in the new array *before* moving the others over (args
+				// might refer to one of our own elements)
+				unsigned int new_capacity = GrowthPolicy::grow(mCapacity);
+				T* new_array = allocate(new_capacity);
+				new (&new_array[mSize]) T(std::forward<Args>(args)...);
+				relocate(new_array, mData, mSize);
+				deallocate(mData);
+				mData = new_array;
+				mCapacity = new_capacity;
+			}
+			else
+				new (&mData[mSize]) T(std::forward<Args>(args)...);
+
+			// (sneakily) increase our size in the process
+			return mData[mSize++];
 		}
 
 
@@ -249,20 +550,41 @@ namespace ssuds
 		/// </summary>
 		void clear()
 		{
-			if (mData)
-				delete[] mData;
-			mData = nullptr;
+			destroy(mData, mSize);
+			deallocate(mData);
+			mData = this->inline_data();
 			mSize = 0;
-			mCapacity = 0;
+			mCapacity = InlineCapacity;
 		}
 
+		/// <summary>
+		/// Gets a pointer to the (contiguous) elements, for loops that want to skip per-access checks.
+		/// It is invalidated by anything that changes the capacity
+		/// </summary>
+		/// <returns>a pointer to the first element (nullptr if nothing has been allocated)</returns>
+		T* data()
+		{
+			return mData;
+		}
+
+
+		/// <summary>
+		/// Gets a pointer to the (contiguous) elements, for loops that want to skip per-access checks
+		/// </summary>
+		/// <returns>a pointer to the first element (nullptr if nothing has been allocated)</returns>
+		const T* data() const
+		{
+			return mData;
+		}
+
+
 		/// <summary>
 		/// Returns a special iterator value indicating we've reached the end of iteration
 		/// </summary>
 		/// <returns>special end iterator value</returns>
 		ArrayListIterator end() const
 		{
-			return ArrayListIterator(this, ArrayListIteratorType::forward, mSize);
+			return ArrayListIterator(mData + mSize);
 		}
 
 		/// <summary>
@@ -271,10 +593,10 @@ namespace ssuds
 		/// <param name="val">the value to search for</param>
 		/// <param name="start_index">the index to start searching at</param>
 		/// <returns></returns>
-		int find(const T val, unsigned int start_index = 0) const
+		int find(const T& val, unsigned int start_index = 0) const
 		{
 			if (start_index >= mSize)
-				throw std::out_of_range("Invalid index: " + std::to_string(start_index));
+				_throw_index_error(start_index);
 
 			for (unsigned int i = start_index; i < mSize; i++)
 			{
@@ -296,17 +618,23 @@ namespace ssuds
 		void insert(T val, unsigned int index)
 		{
 			if (index > mSize)
-				throw std::out_of_range("Invalid index: " + std::to_string(index));
+				_throw_index_error(index);
 
 			// check to see if we need to increase capacity first
 			grow();
 
-			// Move all the elements that come *after* index up one spot
-			for (unsigned int i = mSize; i > index; i--)
-				mData[i] = mData[i - 1];
+			if (index == mSize)
+				new (&mData[mSize]) T(std::move(val));
+			else
+			{
+				// Move all the elements that come *after* index up one spot (the last one
+				// goes into a raw slot, so it is constructed rather than assigned)
+				new (&mData[mSize]) T(std::move(mData[mSize - 1]));
+				move_elements(mData + index + 1, mData + index, mSize - index - 1);
 
-			// Put our new elements in spot index and increase our size
-			mData[index] = val;
+				// Put our new element in spot index
+				mData[index] = std::move(val);
+			}
 			mSize++;
 		}
 
@@ -315,9 +643,9 @@ namespace ssuds
 		/// Create and return a reverse iterator 
 		/// </summary>
 		/// <returns>a reverse iterator</returns>
-		ArrayListIterator rbegin() const
+		ArrayListReverseIterator rbegin() const
 		{
-			return ArrayListIterator(this, ArrayListIteratorType::backwards, mSize - 1);
+			return ArrayListReverseIterator(end());
 		}
 
 
@@ -325,9 +653,9 @@ namespace ssuds
 		/// Returns a special reverse end iterator value indicating we've reached the end of iteration
 		/// </summary>
 		/// <returns>special reverse end iterator value</returns>
-		ArrayListIterator rend() const
+		ArrayListReverseIterator rend() const
 		{
-			return ArrayListIterator(this, ArrayListIteratorType::backwards, -1);
+			return ArrayListReverseIterator(begin());
 		}
 
 
@@ -340,17 +668,17 @@ namespace ssuds
 		T remove(unsigned int index, bool resize_if_necessary = true)
 		{
 			if (index >= mSize)
-				throw std::out_of_range("Invalid index: " + std::to_string(index));
+				_throw_index_error(index);
 
 			// Get the value we'll return at the end (the element removed)
-			T result = mData[index];
+			T result = std::move(mData[index]);
 
 			// Move all elements that come after index down one spot
-			for (unsigned int i = index; i < mSize - 1; i++)
-				mData[i] = mData[i + 1];
+			move_elements(mData + index, mData + index + 1, mSize - index - 1);
 
-			// Decrement our size
+			// The last slot is now unused (its contents were moved down)
 			mSize--;
+			destroy(mData + mSize, 1);
 
 			// Shrink, if applicable and requested
 			if (resize_if_necessary)
@@ -360,6 +688,18 @@ namespace ssuds
 			return result;
 		}
 
+		/// <summary>
+		/// Makes sure there is room for at least new_capacity elements (so that many can be added
+		/// without re-allocating).  This never reduces the capacity
+		/// </summary>
+		/// <param name="new_capacity">the number of elements to make room for</param>
+		void reserve(unsigned int new_capacity)
+		{
+			if (new_capacity > mCapacity)
+				reallocate(new_capacity);
+		}
+
+
 		/// <summary>
 		/// Removes all occurrences of a given value.  Uses find and remove internally to do the removal
 		/// </summary>
@@ -388,6 +728,16 @@ namespace ssuds
 			return num_removed;
 		}
 
+		/// <summary>
+		/// Reduces the capacity to the current size, releasing any spare slots
+		/// </summary>
+		void shrink_to_fit()
+		{
+			if (mCapacity > mSize)
+				reallocate(mSize);
+		}
+
+
 		/// <summary>
 		/// Returns the size of the internal array (i.e.) how many things are being stored in the ArrayList
 		/// </summary>
@@ -400,65 +750,178 @@ namespace ssuds
 
 	protected:
 		/// <summary>
-		/// An internal method to resize the array if we are currently at capacity (if we are not, nothing is done)
+		/// Gets raw (uninitialized) memory for count elements (nullptr if count is 0)
 		/// </summary>
-		void grow()
+		static T* allocate(unsigned int count)
 		{
-			if (mSize == mCapacity)
+			if (count == 0)
+				return nullptr;
+			return static_cast<T*>(::operator new(sizeof(T) * count));
+		}
+
+
+		/// <summary>
+		/// Releases memory obtained from allocate (the elements must already be destroyed).  Our inline
+		/// storage is left alone
+		/// </summary>
+		void deallocate(T* data)
+		{
+			if (data != this->inline_data())
+				::operator delete(data);
+		}
+
+
+		/// <summary>
+		/// Calls the destructor of the count elements starting at data
+		/// </summary>
+		static void destroy(T* data, unsigned int count)
+		{
+			if (!std::is_trivially_destructible<T>::value)
 			{
-				// Allocate what will become the new array
-				T* new_array = nullptr;
-				if (mCapacity == 0)
-					new_array = new T[msMinCapacity];
-				else
-					new_array = new T[mCapacity * 2];
+				for (unsigned int i = 0; i < count; i++)
+					data[i].~T();
+			}
+		}
 
-				// Copy over data from the old array (if any)
-				if (mData != nullptr)
-				{
-					for (unsigned int i = 0; i < mSize; i++)
-						new_array[i] = mData[i];
 
-					// Destroy the old array
-					delete[] mData;
+		/// <summary>
+		/// Copy-constructs count elements from src into the raw slots at dest (memcpy for trivially-copyable types)
+		/// </summary>
+		static void copy_construct(T* dest, const T* src, unsigned int count)
+		{
+			if (std::is_trivially_copyable<T>::value)
+			{
+				if (count > 0)
+					memcpy((void*)dest, (const void*)src, sizeof(T) * count);
+			}
+			else
+			{
+				for (unsigned int i = 0; i < count; i++)
+					new (&dest[i]) T(src[i]);
+			}
+		}
+
+
+		/// <summary>
+		/// Moves count elements from src into the raw slots at dest and destroys the originals, leaving
+		/// src as raw memory (a single memcpy for trivially-copyable types)
+		/// </summary>
+		static void relocate(T* dest, T* src, unsigned int count)
+		{
+			if (std::is_trivially_copyable<T>::value)
+			{
+				if (count > 0)
+					memcpy((void*)dest, (const void*)src, sizeof(T) * count);
+			}
+			else
+			{
+				for (unsigned int i = 0; i < count; i++)
+				{
+					new (&dest[i]) T(std::move(src[i]));
+					src[i].~T();
 				}
+			}
+		}
 
-				// Make the new array *the* array
-				mData = new_array;
 
-				// Note that our capacity is now double what it used to be
-				if (mCapacity == 0)
-					mCapacity = msMinCapacity;
-				else
-					mCapacity *= 2;
+		/// <summary>
+		/// Move-assigns count (constructed) elements from src to (constructed) dest (memmove for trivially-copyable
+		/// types).  The ranges may overlap, which is what insert and remove need when sliding elements over by one spot
+		/// </summary>
+		static void move_elements(T* dest, T* src, unsigned int count)
+		{
+			if (std::is_trivially_copyable<T>::value)
+			{
+				if (count > 0)
+					memmove((void*)dest, (const void*)src, sizeof(T) * count);
+			}
+			else if (dest < src)
+			{
+				for (unsigned int i = 0; i < count; i++)
+					dest[i] = std::move(src[i]);
+			}
+			else
+			{
+				for (unsigned int i = count; i > 0; i--)
+					dest[i - 1] = std::move(src[i - 1]);
 			}
 		}
 
 
 		/// <summary>
-		/// An internal method to see if the array can be shrunk (capacity reduced by half, down to msMinCapacity)
+		/// Moves our elements to a new array with the given capacity (which must be >= mSize).  A capacity
+		/// that fits in the inline storage moves them there instead
 		/// </summary>
-		void shrink()
+		void reallocate(unsigned int new_capacity)
 		{
-			if (mSize < mCapacity / 2 && mCapacity >= msMinCapacity * 2)
+			T* new_array;
+			if (new_capacity <= InlineCapacity)
 			{
-				// Allocate what will become the new array
-				T* new_array = new T[mCapacity / 2];
+				new_array = this->inline_data();
+				new_capacity = InlineCapacity;
+				if (mData == new_array)
+					return;
+			}
+			else
+				new_array = allocate(new_capacity);
+			relocate(new_array, mData, mSize);
+			deallocate(mData);
+			mData = new_array;
+			mCapacity = new_capacity;
+		}
 
-				// Copy over data from the old array (if any)
-				for (unsigned int i = 0; i < mSize; i++)
-					new_array[i] = mData[i];
-			
 
-				// Destroy the old array
-				delete[] mData;
+		/// <summary>
+		/// Takes over the elements of other (we must be empty, using our inline storage).  A heap array is
+		/// simply stolen; elements in other's inline storage are moved over.  other is left empty
+		/// </summary>
+		void take(ArrayList& other)
+		{
+			if (InlineCapacity > 0 && other.mData == other.inline_data())
+				relocate(mData, other.mData, other.mSize);
+			else
+			{
+				mData = other.mData;
+				mCapacity = other.mCapacity;
+				other.mData = other.inline_data();
+				other.mCapacity = InlineCapacity;
+			}
+			mSize = other.mSize;
+			other.mSize = 0;
+		}
 
-				// Make the new array *the* array
-				mData = new_array;
 
-				// Note that our capacity is now double what it used to be
-				mCapacity /= 2;
+		/// <summary>
+		/// An internal method to resize the array if we are currently at capacity (if we are not, nothing is done)
+		/// </summary>
+		void grow()
+		{
+			if (mSize == mCapacity)
+			{
+				// (with the default policy, our capacity will be double what it used to be)
+				reallocate(GrowthPolicy::grow(mCapacity));
 			}
 		}
+
+
+		/// <summary>
+		/// An internal method to see if the array can be shrunk (with the default policy, capacity is reduced
+		/// by half when less than half of it is used)
+		/// </summary>
+		void shrink()
+		{
+			unsigned int new_capacity = GrowthPolicy::shrink(mSize, mCapacity);
+			if (new_capacity < mCapacity && new_capacity >= mSize)
+				reallocate(new_capacity);
+		}
 	};
+
+
+	/// <summary>
+	/// An ArrayList that keeps up to N elements inside the object itself, so short lists (e.g. the neighbors
+	/// of a low-degree node) never touch the heap.  It moves to a heap array, like a regular ArrayList, once
+	/// it grows beyond N.
+	/// </summary>
+	template <class T, unsigned int N, class GrowthPolicy = DoublingGrowthPolicy>
+	using SmallArrayList = ArrayList<T, GrowthPolicy, N>;
 }
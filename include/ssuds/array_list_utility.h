@@ -1,6 +1,25 @@
 #pragma once
 #include <array_list.h>
+#include <thread_pool.h>
+#include <random_engine.h>
 #include <random>
+#include <cstddef>
+#include <utility>
+#include <new>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <memory>
+
+// SSUDS_PREFETCH(address) hints that the cache line holding address will be read soon
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define SSUDS_PREFETCH(address) _mm_prefetch((const char*)(address), _MM_HINT_T0)
+#elif defined(__GNUC__)
+#define SSUDS_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define SSUDS_PREFETCH(address) ((void)0)
+#endif
 
 namespace ssuds
 {
@@ -11,64 +30,410 @@ namespace ssuds
 	enum class SortOrder { ASCENDING, DESCENDING };
 
 	/// <summary>
-	/// A method meant to internally support quicksort.  This helper method does most of the
-	/// work of actually sorting the list.
+	/// A comparator for the sorting functions below: puts small values first
+	/// </summary>
+	struct SortAscending
+	{
+		template <class T>
+		bool operator()(const T& a, const T& b) const
+		{
+			return a < b;
+		}
+	};
+
+
+	/// <summary>
+	/// A comparator for the sorting functions below: puts big values first
+	/// </summary>
+	struct SortDescending
+	{
+		template <class T>
+		bool operator()(const T& a, const T& b) const
+		{
+			return b < a;
+		}
+	};
+
+
+	/// <summary>
+	/// An operation-count policy for quicksort that counts nothing (so the counting compiles away)
+	/// </summary>
+	class NullOpCounter
+	{
+	public:
+		void add(unsigned long)
+		{
+			// intentionally empty
+		}
+
+		unsigned long total() const
+		{
+			return 0;
+		}
+	};
+
+
+	/// <summary>
+	/// An operation-count policy for quicksort that counts element swaps / moves
+	/// </summary>
+	class OpCounter
+	{
+	protected:
+		unsigned long mTotal;
+
+	public:
+		OpCounter() : mTotal(0)
+		{
+			// intentionally empty
+		}
+
+		void add(unsigned long amount)
+		{
+			mTotal += amount;
+		}
+
+		unsigned long total() const
+		{
+			return mTotal;
+		}
+	};
+
+
+	/// <summary>
+	/// Ranges shorter than this are finished with an insertion sort
+	/// </summary>
+	static const int _sort_insertion_cutoff = 24;
+
+	/// <summary>
+	/// Ranges longer than this pick their pivot with Tukey's ninther rather than a median of 3
+	/// </summary>
+	static const int _sort_ninther_cutoff = 128;
+
+	/// <summary>
+	/// How many element moves _partial_insertion_sort may make before giving up
+	/// </summary>
+	static const int _sort_partial_insertion_limit = 8;
+
+
+	/// <summary>
+	/// Swaps two values (and counts it)
+	/// </summary>
+	template <class T, class Counter>
+	void _sort_swap(T& a, T& b, Counter& counter)
+	{
+		std::swap(a, b);
+		counter.add(1);
+	}
+
+
+	/// <summary>
+	/// Puts the three values in order
+	/// </summary>
+	template <class T, class Compare, class Counter>
+	void _sort3(T* a, T* b, T* c, Compare& comp, Counter& counter)
+	{
+		if (comp(*b, *a))
+			_sort_swap(*a, *b, counter);
+		if (comp(*c, *b))
+			_sort_swap(*b, *c, counter);
+		if (comp(*b, *a))
+			_sort_swap(*a, *b, counter);
+	}
+
+
+	/// <summary>
+	/// A value taken out of a range during a sort.  Whatever happens (including the comparator throwing), it
+	/// is put back into mHole when it goes out of scope, so an interrupted sort never loses a value.
 	/// </summary>
-	/// <typeparam name="T">The type of datatype held by the ArrayList</typeparam>
-	/// <param name="aList">The ArrayList we're sorting</param>
-	/// <param name="type">The type of sort we're performing</param>
-	/// <param name="left">The left-most index to consider</param>
-	/// <param name="right">The right-most index to consider (inclusive)</param>
-	/// <param name="op_count">Used to track the number of swaps</param>
 	template <class T>
-	int _quicksort_pivot(ArrayList<T>& aList, SortOrder type, int left, int right, unsigned long& op_count)
+	struct _SortHole
 	{
-		// Pick a value to pivot around.  Some authors choose the first element, but I don't
-		// think that will perform well for an already-sorted list.  I generally pick the middle 
-		// element.  Put this value in the last spot so we leave it alone for a bit
-		int mid_index = (left + right) / 2;
-		T pivot_val = aList[mid_index];
-		aList[mid_index] = aList[right];
-		aList[right] = pivot_val;
+		T mValue;
+		T* mHole;
+
+		_SortHole(T* hole) : mValue(std::move(*hole)), mHole(hole)
+		{
+			// empty, on purpose
+		}
 
-		// Scan indicies from left...right.  If we see a value less than the pivot value, swap
-		// it with the swap_index (and add one to swap_index).  Once we reach the end, the swap index
-		// will hold the index of the pivot_val (or one of those values if there is more than one).  Note
-		// that the element at right should always trigger a swap since we put the pivot value there.
-		int swap_index = left;
-		for (int i = left; i <= right; i++)
+		~_SortHole()
 		{
-			if (pivot_val == aList[i] || _out_of_order(type, pivot_val, aList[i]))
+			*mHole = std::move(mValue);
+		}
+	};
+
+
+	/// <summary>
+	/// Insertion-sorts the range [first, last).  If guarded is false, the caller promises that the value
+	/// just before first is not greater than anything in the range, so the inner loop can skip its bounds check.
+	/// </summary>
+	template <class T, class Compare, class Counter>
+	void _insertion_sort(T* first, T* last, Compare& comp, Counter& counter, bool guarded)
+	{
+		if (first == last)
+			return;
+		for (T* cur = first + 1; cur != last; ++cur)
+		{
+			if (!comp(*cur, *(cur - 1)))
+				continue;
+			_SortHole<T> hole(cur);
+			do
 			{
-				++op_count;
-				T temp = aList[i];
-				aList[i] = aList[swap_index];
-				aList[swap_index++] = temp;
+				*hole.mHole = std::move(*(hole.mHole - 1));
+				--hole.mHole;
+				counter.add(1);
+			} while ((!guarded || hole.mHole != first) && comp(hole.mValue, *(hole.mHole - 1)));
+		}
+	}
+
+
+	/// <summary>
+	/// Like _insertion_sort, but gives up once it has moved more than a few values.  Used to finish off
+	/// ranges that look (nearly) sorted already.
+	/// </summary>
+	/// <returns>true if the range is now sorted</returns>
+	template <class T, class Compare, class Counter>
+	bool _partial_insertion_sort(T* first, T* last, Compare& comp, Counter& counter)
+	{
+		if (first == last)
+			return true;
+		int moves = 0;
+		for (T* cur = first + 1; cur != last; ++cur)
+		{
+			if (!comp(*cur, *(cur - 1)))
+				continue;
+			{
+				_SortHole<T> hole(cur);
+				do
+				{
+					*hole.mHole = std::move(*(hole.mHole - 1));
+					--hole.mHole;
+					counter.add(1);
+				} while (hole.mHole != first && comp(hole.mValue, *(hole.mHole - 1)));
+				moves += (int)(cur - hole.mHole);
 			}
+			if (moves > _sort_partial_insertion_limit)
+				return cur + 1 == last;
 		}
+		return true;
+	}
+
 
-		return swap_index - 1;
+	/// <summary>
+	/// Moves data[root] down the binary heap data[0...size-1] until it is in a valid spot
+	/// </summary>
+	template <class T, class Compare, class Counter>
+	void _sift_down(T* data, std::ptrdiff_t root, std::ptrdiff_t size, Compare& comp, Counter& counter)
+	{
+		_SortHole<T> hole(data + root);
+		while (true)
+		{
+			std::ptrdiff_t child = 2 * root + 1;
+			if (child >= size)
+				break;
+			if (child + 1 < size && comp(data[child], data[child + 1]))
+				child++;
+			if (!comp(hole.mValue, data[child]))
+				break;
+			*hole.mHole = std::move(data[child]);
+			counter.add(1);
+			root = child;
+			hole.mHole = data + root;
+		}
 	}
 
+
 	/// <summary>
-	/// An internal support method used by quicksort.  This method calls pivot (which
-	/// does most of the actual work of quicksort).  Then this method
-	/// recursively calls quicksort on the two halves
+	/// Heapsorts the range [first, last) -- quicksort's fallback when its pivots keep going badly
 	/// </summary>
-	/// <typeparam name="T">The type of ArrayList we're working on</typeparam>
-	/// <param name="alist">The ArrayList we're sorting</param>
-	/// <param name="type">The type of sort we're trying to implement</param>
-	/// <param name="left">The left-most index of the portion of alist we're modifying</param>
-	/// <param name="right">The right-most index of the portion of alist we're modifying</param>
-	/// <param name="op_count">used to track the total number of operations performed by quicksort</param>
-	template <class T>
-	void _quicksort_recursive(ArrayList<T>& aList, SortOrder type, int left, int right, unsigned long& op_count)
+	template <class T, class Compare, class Counter>
+	void _heapsort(T* first, T* last, Compare& comp, Counter& counter)
+	{
+		std::ptrdiff_t size = last - first;
+		for (std::ptrdiff_t i = size / 2 - 1; i >= 0; i--)
+			_sift_down(first, i, size, comp, counter);
+		for (std::ptrdiff_t end = size - 1; end > 0; end--)
+		{
+			_sort_swap(first[0], first[end], counter);
+			_sift_down(first, 0, end, comp, counter);
+		}
+	}
+
+
+	/// <summary>
+	/// Partitions [first, last) around the pivot in *first: values less than it end up to its left, everything
+	/// else to its right.  The range must contain a value that isn't less than the pivot after first (the
+	/// pivot selection guarantees this).
+	/// </summary>
+	/// <param name="already_partitioned">set to true if no values had to be swapped</param>
+	/// <returns>where the pivot ended up</returns>
+	template <class T, class Compare, class Counter>
+	T* _partition_right(T* first, T* last, Compare& comp, Counter& counter, bool& already_partitioned)
+	{
+		// The pivot stays put in *first until the end, so we compare against it in place
+		const T& pivot = *first;
+		T* left = first;
+		T* right = last;
+
+		// Find the first value that isn't less than the pivot, then the last value that is.  If the first
+		// search didn't move, there may not be a value less than the pivot, so the second one needs a guard
+		while (comp(*++left, pivot));
+		if (left - 1 == first)
+		{
+			while (left < right && !comp(*--right, pivot));
+		}
+		else
+		{
+			while (!comp(*--right, pivot));
+		}
+
+		already_partitioned = left >= right;
+		while (left < right)
+		{
+			_sort_swap(*left, *right, counter);
+			while (comp(*++left, pivot));
+			while (!comp(*--right, pivot));
+		}
+
+		T* pivot_pos = left - 1;
+		if (pivot_pos != first)
+			_sort_swap(*first, *pivot_pos, counter);
+		return pivot_pos;
+	}
+
+
+	/// <summary>
+	/// Partitions [first, last) around the pivot in *first, putting values equal to the pivot on its left.
+	/// Used when the pivot equals the previous pivot (which sits just before first), in which case nothing in
+	/// the range is less than it and the whole left part is done.  This is what keeps many-duplicate inputs
+	/// linear.
+	/// </summary>
+	/// <returns>where the pivot ended up</returns>
+	template <class T, class Compare, class Counter>
+	T* _partition_left(T* first, T* last, Compare& comp, Counter& counter)
 	{
-		if (left >= right)
+		const T& pivot = *first;
+		T* left = first;
+		T* right = last;
+
+		while (comp(pivot, *--right));
+		if (right + 1 == last)
+		{
+			while (left < right && !comp(pivot, *++left));
+		}
+		else
+		{
+			while (!comp(pivot, *++left));
+		}
+
+		while (left < right)
+		{
+			_sort_swap(*left, *right, counter);
+			while (comp(pivot, *--right));
+			while (!comp(pivot, *++left));
+		}
+
+		if (right != first)
+			_sort_swap(*first, *right, counter);
+		return right;
+	}
+
+
+	/// <summary>
+	/// Swaps a few values from the middle of a badly-unbalanced partition to its ends, so the next pivot
+	/// choices can't be steered by the same pattern again
+	/// </summary>
+	template <class T, class Counter>
+	void _break_patterns(T* first, T* last, Counter& counter)
+	{
+		std::ptrdiff_t size = last - first;
+		if (size < _sort_insertion_cutoff)
 			return;
-		int pivot_index = _quicksort_pivot(aList, type, left, right, op_count);
-		_quicksort_recursive(aList, type, left, pivot_index - 1, op_count);
-		_quicksort_recursive(aList, type, pivot_index + 1, right, op_count);
+		std::ptrdiff_t quarter = size / 4;
+		_sort_swap(first[0], first[quarter], counter);
+		_sort_swap(last[-1], last[-quarter], counter);
+		if (size > _sort_ninther_cutoff)
+		{
+			_sort_swap(first[1], first[quarter + 1], counter);
+			_sort_swap(first[2], first[quarter + 2], counter);
+			_sort_swap(last[-2], last[-(quarter + 1)], counter);
+			_sort_swap(last[-3], last[-(quarter + 2)], counter);
+		}
+	}
+
+
+	/// <summary>
+	/// The main pattern-defeating quicksort loop over [first, last).  It recurses into the smaller side of
+	/// each partition and loops on the larger one, so the stack depth is at most log2(n).
+	/// </summary>
+	/// <param name="bad_allowed">how many badly-unbalanced partitions we put up with before switching to heapsort</param>
+	/// <param name="leftmost">false if the value just before first is a previous pivot (not greater than anything in the range)</param>
+	template <class T, class Compare, class Counter>
+	void _pdqsort_loop(T* first, T* last, Compare& comp, Counter& counter, int bad_allowed, bool leftmost)
+	{
+		while (true)
+		{
+			std::ptrdiff_t size = last - first;
+			if (size < _sort_insertion_cutoff)
+			{
+				_insertion_sort(first, last, comp, counter, leftmost);
+				return;
+			}
+
+			// Move the pivot (median of 3, or Tukey's ninther for big ranges) into *first
+			std::ptrdiff_t half = size / 2;
+			if (size > _sort_ninther_cutoff)
+			{
+				_sort3(first, first + half, last - 1, comp, counter);
+				_sort3(first + 1, first + (half - 1), last - 2, comp, counter);
+				_sort3(first + 2, first + (half + 1), last - 3, comp, counter);
+				_sort3(first + (half - 1), first + half, first + (half + 1), comp, counter);
+				_sort_swap(*first, *(first + half), counter);
+			}
+			else
+				_sort3(first + half, first, last - 1, comp, counter);
+
+			// If the pivot equals the previous one, everything equal to it is already in place
+			if (!leftmost && !comp(*(first - 1), *first))
+			{
+				first = _partition_left(first, last, comp, counter) + 1;
+				continue;
+			}
+
+			bool already_partitioned;
+			T* pivot_pos = _partition_right(first, last, comp, counter, already_partitioned);
+			std::ptrdiff_t left_size = pivot_pos - first;
+			std::ptrdiff_t right_size = last - (pivot_pos + 1);
+
+			if (left_size < size / 8 || right_size < size / 8)
+			{
+				if (--bad_allowed == 0)
+				{
+					_heapsort(first, last, comp, counter);
+					return;
+				}
+				_break_patterns(first, pivot_pos, counter);
+				_break_patterns(pivot_pos + 1, last, counter);
+			}
+			else if (already_partitioned && _partial_insertion_sort(first, pivot_pos, comp, counter)
+				&& _partial_insertion_sort(pivot_pos + 1, last, comp, counter))
+			{
+				// The input looks sorted, and it was
+				return;
+			}
+
+			if (left_size < right_size)
+			{
+				_pdqsort_loop(first, pivot_pos, comp, counter, bad_allowed, leftmost);
+				first = pivot_pos + 1;
+				leftmost = false;
+			}
+			else
+			{
+				_pdqsort_loop(pivot_pos + 1, last, comp, counter, bad_allowed, false);
+				last = pivot_pos;
+			}
+		}
 	}
 
 
@@ -89,58 +454,573 @@ namespace ssuds
 	}
 
 
+	/// <summary>
+	/// A branchless lower bound over the sorted values data[0...size-1].  Each step halves the range with a
+	/// conditional add (which compiles to a cmov, so there is nothing to mispredict) and prefetches both
+	/// places the next step might look.
+	/// </summary>
+	/// <param name="num_ops">has the number of comparisons added to it</param>
+	/// <returns>the index of the first value that doesn't belong before value (size if there is none)</returns>
+	template <class T, class Compare>
+	unsigned int _lower_bound_branchless(const T* data, unsigned int size, const T& value, Compare comp, unsigned long& num_ops)
+	{
+		if (size == 0)
+			return 0;
+		const T* base = data;
+		unsigned int length = size;
+		while (length > 1)
+		{
+			unsigned int half = length / 2;
+			SSUDS_PREFETCH(base + half / 2);
+			SSUDS_PREFETCH(base + half + half / 2);
+			base += comp(base[half - 1], value) ? half : 0;
+			length -= half;
+			num_ops++;
+		}
+		num_ops++;
+		return (unsigned int)(base - data) + (comp(*base, value) ? 1 : 0);
+	}
+
+
+	/// <summary>
+	/// Finds where search_value is (or would go) in a sorted ArrayList, using a branchless binary search
+	/// </summary>
+	/// <typeparam name="T">The type of ArrayList we're working on</typeparam>
+	/// <param name="alist">The sorted ArrayList to search within</param>
+	/// <param name="sort_order">The way alist is sorted</param>
+	/// <param name="search_value">The value to search for</param>
+	/// <param name="num_ops">If not nullptr, the number of comparisons performed is written here</param>
+	/// <returns>The index of the first value that doesn't belong before search_value (alist.size() if there is none)</returns>
+	template <class T>
+	unsigned int find_lower_bound(const ArrayList<T>& alist, SortOrder sort_order, const T& search_value, unsigned long* num_ops = nullptr)
+	{
+		unsigned long comparisons = 0;
+		unsigned int result;
+		if (sort_order == SortOrder::ASCENDING)
+			result = _lower_bound_branchless(alist.data(), alist.size(), search_value, SortAscending(), comparisons);
+		else
+			result = _lower_bound_branchless(alist.data(), alist.size(), search_value, SortDescending(), comparisons);
+		if (num_ops != nullptr)
+			*num_ops = comparisons;
+		return result;
+	}
+
+
 	/// <summary>
 	/// If we have a sorted ArrayList, we can find a particular value much more quickly using
 	/// this binary search function (as opposed to a linear search, which is what the ArrayList::find
-	/// method implements)
+	/// method implements).  The search itself is find_lower_bound's branchless one.
 	/// </summary>
 	/// <typeparam name="T">The type of ArrayList we're working on</typeparam>
 	/// <param name="alist">The sorted ArrayList to search within</param>
 	/// <param name="sort_order">The way alist is sorted</param>
 	/// <param name="search_value">The value to search for</param>
 	/// <param name="num_ops">If not nullptr, the number of comparisons performed is written here</param>
-	/// <returns>The index of an occurrence of search_value (or -1 if none are present in alist)</returns>
+	/// <returns>The index of the first occurrence of search_value (or -1 if none are present in alist)</returns>
 	template <class T>
 	int find_binary_search(const ArrayList<T>& alist, SortOrder sort_order, const T& search_value, unsigned long* num_ops = nullptr)
 	{
-		long comparisons = 0;
-		int left = 0;
-		int right = alist.size() - 1;
-		while (left <= right)
-		{
-			int mid = (left + right) >> 1;			// divide by 2 (the average)
-			comparisons++;
-			if (alist[mid] == search_value)
-			{
-				if (num_ops != nullptr)
-					*num_ops = comparisons;
-				return mid;
-			}
-			else if (_out_of_order(sort_order, search_value, alist[mid]))
-				left = mid + 1;
-			else
-				right = mid - 1;
-		} 
-		if (num_ops != nullptr)
-			*num_ops = comparisons;
+		unsigned int index = find_lower_bound(alist, sort_order, search_value, num_ops);
+		if (index < alist.size() && alist.data()[index] == search_value)
+			return (int)index;
 		return -1;
 	}
 
-	
+
+	/// <summary>
+	/// Sorts [first, last) with _pdqsort_loop, allowing log2(n) bad partitions
+	/// </summary>
+	template <class T, class Compare, class Counter>
+	void _pdqsort(T* first, T* last, Compare& comp, Counter& counter)
+	{
+		int bad_allowed = 1;
+		for (std::ptrdiff_t n = last - first; n > 1; n >>= 1)
+			bad_allowed++;
+		_pdqsort_loop(first, last, comp, counter, bad_allowed, true);
+	}
+
+
+	/// <summary>
+	/// Performs an in-place quicksort, O(n log n), on alist.  This is a pattern-defeating quicksort: small
+	/// ranges are finished with insertion sort, sorted and many-duplicate inputs run in linear time, and if
+	/// the pivots keep going badly it falls back to heapsort, so the worst case is still O(n log n).
+	/// comp(a, b) should return true if a belongs before b (SortAscending, SortDescending, std::less, a lambda...).
+	/// Since it is a template parameter the comparisons are inlined.
+	/// </summary>
+	/// <typeparam name="T">The type of ArrayList we're working on</typeparam>
+	/// <typeparam name="Compare">The comparator type</typeparam>
+	/// <typeparam name="Counter">An operation-count policy (NullOpCounter or OpCounter)</typeparam>
+	/// <param name="alist">the ArrayList we wish to sort</param>
+	/// <param name="comp">the comparator</param>
+	/// <param name="counter">has the number of swaps / moves added to it</param>
+	template <class T, class Compare, class Counter>
+	void quicksort(ArrayList<T>& alist, Compare comp, Counter& counter)
+	{
+		// Reference: https://arxiv.org/abs/2106.05123 (Peters, "Pattern-defeating Quicksort")
+		T* data = alist.data();
+		_pdqsort(data, data + alist.size(), comp, counter);
+	}
+
+
+	/// <summary>
+	/// Performs an in-place quicksort on alist with the given comparator (and no operation counting)
+	/// </summary>
+	/// <param name="alist">the ArrayList we wish to sort</param>
+	/// <param name="comp">the comparator</param>
+	template <class T, class Compare>
+	void quicksort(ArrayList<T>& alist, Compare comp)
+	{
+		NullOpCounter counter;
+		quicksort(alist, comp, counter);
+	}
+
+
 	/// <summary>
 	/// Performs an in-place quicksort operation, O(n log n), on alist
 	/// </summary>
 	/// <typeparam name="T">The type of ArrayList we're working on</typeparam>
 	/// <param name="alist">the ArrayList we wish to sort</param>
 	/// <param name="type">The type of sort to perform</param>
-	/// <returns>The number of swaps performed while sorting</returns>
+	/// <returns>The number of swaps / moves performed while sorting</returns>
 	template <class T>
 	unsigned long quicksort(ArrayList<T>& alist, SortOrder type)
 	{
-		// Reference: https://en.wikipedia.org/wiki/Quicksort
-		unsigned long op_count = 0;
-		_quicksort_recursive(alist, type, 0, alist.size() - 1, op_count);
-		return op_count;
+		OpCounter counter;
+		if (type == SortOrder::ASCENDING)
+			quicksort(alist, SortAscending(), counter);
+		else
+			quicksort(alist, SortDescending(), counter);
+		return counter.total();
+	}
+
+
+	/// <summary>
+	/// Lists shorter than this are sorted serially by parallel_sort (the threads would cost more than they save)
+	/// </summary>
+	static const unsigned int _parallel_sort_cutoff = 1 << 16;
+
+	/// <summary>
+	/// How many buckets parallel_sort makes per thread (more buckets = better load balance)
+	/// </summary>
+	static const unsigned int _parallel_sort_buckets_per_thread = 4;
+
+	/// <summary>
+	/// How many samples parallel_sort takes per bucket when choosing splitters
+	/// </summary>
+	static const unsigned int _parallel_sort_oversampling = 32;
+
+
+	/// <summary>
+	/// Finds the sample-sort bucket of a value.  With splitters s[0] <= s[1] <= ..., bucket 2j holds the values
+	/// between s[j-1] and s[j], and bucket 2j+1 holds the values equal to s[j].  Those "equality buckets" need no
+	/// sorting, which keeps inputs with a few very common values from piling up in one bucket.
+	/// </summary>
+	/// <returns>the bucket number (0...2*num_splitters)</returns>
+	template <class T, class Compare>
+	unsigned int _sample_sort_bucket(const T* splitters, unsigned int num_splitters, const T& value, Compare& comp)
+	{
+		unsigned int low = 0;
+		unsigned int high = num_splitters;
+		while (low < high)
+		{
+			unsigned int mid = (low + high) / 2;
+			if (comp(splitters[mid], value))
+				low = mid + 1;
+			else
+				high = mid;
+		}
+		if (low < num_splitters && !comp(value, splitters[low]))
+			return 2 * low + 1;
+		return 2 * low;
+	}
+
+
+	/// <summary>
+	/// The second half of a parallel bucket-based algorithm (parallel_sort, parallel_shuffle).  data was cut into
+	/// num_chunks equal chunks, and each value has been given a bucket number in bucket_of.  On entry
+	/// counts[chunk * num_buckets + bucket] holds how many of the chunk's values went to the bucket.  The values
+	/// are scattered (in parallel, by chunk) into a scratch buffer grouped by bucket, finish(bucket, first, last)
+	/// is called (in parallel, by bucket) on each bucket's range of the scratch buffer, and the buckets are moved
+	/// back to data in bucket order.  counts is used as scratch space.
+	///
+	/// If finish (e.g. a comparator) or a move of a T throws, every value that already left data is moved back
+	/// before the exception is passed on, so data still holds all of its values, just in some other order.
+	/// </summary>
+	template <class T, class Finish>
+	void _parallel_bucket_scatter(T* data, unsigned int size, const unsigned short* bucket_of, unsigned int* counts,
+		unsigned int num_chunks, unsigned int num_buckets, ThreadPool& pool, Finish finish)
+	{
+		// Turn the counts into each chunk's starting spot within each bucket (buckets in order, and within a
+		// bucket the chunks in order).  The starting spots are kept so an interrupted scatter can be undone
+		std::unique_ptr<unsigned int[]> bucket_starts(new unsigned int[num_buckets + 1]);
+		std::unique_ptr<unsigned int[]> chunk_starts(new unsigned int[num_chunks * num_buckets]);
+		unsigned int running_total = 0;
+		for (unsigned int b = 0; b < num_buckets; b++)
+		{
+			bucket_starts[b] = running_total;
+			for (unsigned int c = 0; c < num_chunks; c++)
+			{
+				unsigned int count = counts[c * num_buckets + b];
+				counts[c * num_buckets + b] = chunk_starts[c * num_buckets + b] = running_total;
+				running_total += count;
+			}
+		}
+		bucket_starts[num_buckets] = size;
+
+		// Scatter the values into the scratch buffer, remembering how far each chunk got.  The scratch buffer is
+		// raw storage: each value is move-constructed into its slot, and every slot that was constructed is
+		// destroyed again before the buffer is freed.
+		T* scratch = static_cast<T*>(::operator new(sizeof(T) * size));
+		std::unique_ptr<unsigned int[]> num_scattered;
+		try
+		{
+			num_scattered.reset(new unsigned int[num_chunks]());
+		}
+		catch (...)
+		{
+			::operator delete(scratch);
+			throw;
+		}
+		try
+		{
+			pool.parallel_for(num_chunks, [&](unsigned int chunk, unsigned int)
+			{
+				unsigned int first = (unsigned int)((unsigned long long)size * chunk / num_chunks);
+				unsigned int last = (unsigned int)((unsigned long long)size * (chunk + 1) / num_chunks);
+				unsigned int* next = counts + chunk * num_buckets;
+				unsigned int i = first;
+				try
+				{
+					for (; i < last; i++)
+						new (scratch + next[bucket_of[i]]++) T(std::move(data[i]));
+				}
+				catch (...)
+				{
+					num_scattered[chunk] = i - first;
+					throw;
+				}
+				num_scattered[chunk] = last - first;
+			});
+		}
+		catch (...)
+		{
+			// Replay each chunk's scatter, moving the values back
+			for (unsigned int c = 0; c < num_chunks; c++)
+			{
+				unsigned int first = (unsigned int)((unsigned long long)size * c / num_chunks);
+				unsigned int* next = chunk_starts.get() + c * num_buckets;
+				for (unsigned int i = first; i < first + num_scattered[c]; i++)
+				{
+					T& value = scratch[next[bucket_of[i]]++];
+					data[i] = std::move(value);
+					value.~T();
+				}
+			}
+			::operator delete(scratch);
+			throw;
+		}
+
+		// Finish each bucket and move it back, remembering how much of each bucket made it.  A bucket that
+		// makes it all the way back destroys its part of the scratch buffer right away.
+		std::unique_ptr<unsigned int[]> num_gathered;
+		try
+		{
+			num_gathered.reset(new unsigned int[num_buckets]());
+			pool.parallel_for(num_buckets, [&](unsigned int bucket, unsigned int)
+			{
+				T* first = scratch + bucket_starts[bucket];
+				unsigned int bucket_size = bucket_starts[bucket + 1] - bucket_starts[bucket];
+				finish(bucket, first, first + bucket_size);
+				T* dest = data + bucket_starts[bucket];
+				unsigned int k = 0;
+				try
+				{
+					for (; k < bucket_size; k++)
+						dest[k] = std::move(first[k]);
+				}
+				catch (...)
+				{
+					num_gathered[bucket] = k;
+					throw;
+				}
+				for (k = 0; k < bucket_size; k++)
+					first[k].~T();
+				num_gathered[bucket] = bucket_size;
+			});
+		}
+		catch (...)
+		{
+			for (unsigned int b = 0; b < num_buckets; b++)
+			{
+				unsigned int gathered = num_gathered ? num_gathered[b] : 0;
+				if (gathered == bucket_starts[b + 1] - bucket_starts[b])
+					continue;
+				for (unsigned int i = bucket_starts[b] + gathered; i < bucket_starts[b + 1]; i++)
+					data[i] = std::move(scratch[i]);
+				for (unsigned int i = bucket_starts[b]; i < bucket_starts[b + 1]; i++)
+					scratch[i].~T();
+			}
+			::operator delete(scratch);
+			throw;
+		}
+		::operator delete(scratch);
+	}
+
+
+	/// <summary>
+	/// Sorts alist using the threads of pool (a parallel sample sort).  Splitters are picked from a sorted
+	/// sample, every value is classified into a bucket between two splitters, the buckets are scattered into
+	/// a scratch buffer, and then each bucket is sorted (with the serial quicksort) and moved back, one task
+	/// per bucket.  Every step but picking the splitters runs in parallel.  Lists shorter than
+	/// _parallel_sort_cutoff are just sorted with quicksort.  comp is called from several threads at once,
+	/// so it must not modify any shared state.  The sort is not stable.
+	/// If comp throws, the exception is passed on and alist keeps all of its values, in some order.
+	/// </summary>
+	/// <typeparam name="T">The type of ArrayList we're working on</typeparam>
+	/// <typeparam name="Compare">The comparator type (see quicksort)</typeparam>
+	/// <param name="alist">the ArrayList we wish to sort</param>
+	/// <param name="comp">the comparator</param>
+	/// <param name="pool">the threads to use</param>
+	template <class T, class Compare>
+	void parallel_sort(ArrayList<T>& alist, Compare comp, ThreadPool& pool)
+	{
+		// Reference: https://en.wikipedia.org/wiki/Samplesort
+		unsigned int size = alist.size();
+		unsigned int num_threads = pool.num_threads();
+		if (num_threads == 1 || size < _parallel_sort_cutoff)
+		{
+			quicksort(alist, comp);
+			return;
+		}
+		T* data = alist.data();
+
+		// Pick the splitters from a sorted random sample (bucket numbers must fit in an unsigned short)
+		unsigned int num_splitters = num_threads * _parallel_sort_buckets_per_thread - 1;
+		if (num_splitters > 4095)
+			num_splitters = 4095;
+		unsigned int num_buckets = 2 * num_splitters + 1;
+		ArrayList<T> samples;
+		samples.reserve((num_splitters + 1) * _parallel_sort_oversampling);
+		std::minstd_rand generator(size);
+		std::uniform_int_distribution<unsigned int> distribution(0, size - 1);
+		for (unsigned int i = 0; i < (num_splitters + 1) * _parallel_sort_oversampling; i++)
+			samples.append(data[distribution(generator)]);
+		quicksort(samples, comp);
+		ArrayList<T> splitters;
+		splitters.reserve(num_splitters);
+		for (unsigned int i = 1; i <= num_splitters; i++)
+			splitters.append(samples[i * _parallel_sort_oversampling]);
+		const T* splitter_data = splitters.data();
+
+		// Classify every value, counting how many of each chunk's values land in each bucket
+		unsigned int num_chunks = num_threads * _parallel_sort_buckets_per_thread;
+		std::unique_ptr<unsigned short[]> bucket_of(new unsigned short[size]);
+		std::unique_ptr<unsigned int[]> offsets(new unsigned int[num_chunks * num_buckets]());
+		pool.parallel_for(num_chunks, [&](unsigned int chunk, unsigned int)
+		{
+			Compare local_comp(comp);
+			unsigned int first = (unsigned int)((unsigned long long)size * chunk / num_chunks);
+			unsigned int last = (unsigned int)((unsigned long long)size * (chunk + 1) / num_chunks);
+			unsigned int* counts = offsets.get() + chunk * num_buckets;
+			for (unsigned int i = first; i < last; i++)
+			{
+				unsigned int bucket = _sample_sort_bucket(splitter_data, num_splitters, data[i], local_comp);
+				bucket_of[i] = (unsigned short)bucket;
+				counts[bucket]++;
+			}
+		});
+
+		// Gather the buckets together, sorting each one (except the equality buckets) on the way
+		_parallel_bucket_scatter(data, size, bucket_of.get(), offsets.get(), num_chunks, num_buckets, pool, [&](unsigned int bucket, T* first, T* last)
+		{
+			if (bucket % 2 == 0)
+			{
+				Compare local_comp(comp);
+				NullOpCounter counter;
+				_pdqsort(first, last, local_comp, counter);
+			}
+		});
+	}
+
+
+	/// <summary>
+	/// Sorts alist with a temporary pool of num_threads threads (see the other parallel_sort).  The pool is
+	/// only started if alist is long enough to be sorted in parallel.
+	/// </summary>
+	/// <param name="alist">the ArrayList we wish to sort</param>
+	/// <param name="comp">the comparator</param>
+	/// <param name="num_threads">the number of threads to use (0 = one per hardware thread)</param>
+	template <class T, class Compare>
+	void parallel_sort(ArrayList<T>& alist, Compare comp, unsigned int num_threads = 0)
+	{
+		if (alist.size() < _parallel_sort_cutoff || num_threads == 1)
+		{
+			quicksort(alist, comp);
+			return;
+		}
+		ThreadPool pool(num_threads);
+		parallel_sort(alist, comp, pool);
+	}
+
+
+	/// <summary>
+	/// Maps radix_sort keys to unsigned integers that sort in the same order.  Unsigned integers are used
+	/// as-is, signed integers get their sign bit flipped, and IEEE floats get their sign bit flipped if
+	/// positive or all bits flipped if negative.
+	/// </summary>
+	template <class K, class Enable = void>
+	struct _RadixKey;
+
+	template <class K>
+	struct _RadixKey<K, typename std::enable_if<std::is_integral<K>::value && !std::is_same<K, bool>::value>::type>
+	{
+		typedef typename std::make_unsigned<K>::type Bits;
+
+		static Bits encode(K key)
+		{
+			if (std::is_signed<K>::value)
+				return (Bits)key ^ ((Bits)1 << (sizeof(K) * 8 - 1));
+			return (Bits)key;
+		}
+	};
+
+	template <>
+	struct _RadixKey<float>
+	{
+		typedef std::uint32_t Bits;
+
+		static Bits encode(float key)
+		{
+			Bits bits;
+			std::memcpy(&bits, &key, sizeof(bits));
+			return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+		}
+	};
+
+	template <>
+	struct _RadixKey<double>
+	{
+		typedef std::uint64_t Bits;
+
+		static Bits encode(double key)
+		{
+			Bits bits;
+			std::memcpy(&bits, &key, sizeof(bits));
+			return (bits & 0x8000000000000000ull) ? ~bits : bits | 0x8000000000000000ull;
+		}
+	};
+
+
+	/// <summary>
+	/// The key extractor radix_sort uses to sort numbers by their own value
+	/// </summary>
+	struct _RadixIdentity
+	{
+		template <class T>
+		const T& operator()(const T& value) const
+		{
+			return value;
+		}
+	};
+
+
+	/// <summary>
+	/// Performs a stable LSD (least-significant digit first) radix sort on alist, ordering the values by
+	/// key(value), which must return an integer or a float / double.  Keys are sorted one byte at a time with
+	/// a counting sort, so this takes O(n * sizeof(key)) time and never compares two values.  The counts for
+	/// every byte are gathered in a single pass up front, and bytes that are the same in every key (e.g. the
+	/// high bytes of small ids) are skipped.  Needs a scratch buffer the size of alist.  Note: NaNs sort after
+	/// +infinity (ascending) and -0.0 sorts before +0.0.
+	/// </summary>
+	/// <typeparam name="T">The type of ArrayList we're working on</typeparam>
+	/// <typeparam name="KeyFunc">The key extractor type</typeparam>
+	/// <param name="alist">the ArrayList we wish to sort</param>
+	/// <param name="key">gets the key to sort each value by (called several times per value, so keep it cheap)</param>
+	/// <param name="type">The type of sort to perform</param>
+	template <class T, class KeyFunc>
+	void radix_sort(ArrayList<T>& alist, KeyFunc key, SortOrder type = SortOrder::ASCENDING)
+	{
+		// Reference: https://en.wikipedia.org/wiki/Radix_sort#Least_significant_digit
+		typedef typename std::decay<decltype(key(std::declval<const T&>()))>::type Key;
+		typedef typename _RadixKey<Key>::Bits Bits;
+		const unsigned int num_digits = sizeof(Bits);
+		unsigned int size = alist.size();
+		if (size < 2)
+			return;
+
+		// For a descending sort, flip every bit of the keys
+		Bits flip = type == SortOrder::DESCENDING ? (Bits)~(Bits)0 : (Bits)0;
+
+		// Count the values with each byte value, for every digit at once
+		unsigned int counts[sizeof(Bits)][256] = {};
+		T* data = alist.data();
+		for (unsigned int i = 0; i < size; i++)
+		{
+			Bits bits = _RadixKey<Key>::encode(key(data[i])) ^ flip;
+			for (unsigned int d = 0; d < num_digits; d++)
+				counts[d][(bits >> (8 * d)) & 0xFF]++;
+		}
+
+		// Each pass moves the values from src to dest.  The scratch buffer's values are constructed by the
+		// first pass that actually runs.
+		T* scratch = static_cast<T*>(::operator new(sizeof(T) * size));
+		bool scratch_constructed = false;
+		T* src = data;
+		T* dest = scratch;
+		for (unsigned int d = 0; d < num_digits; d++)
+		{
+			// Skip this digit if every key has the same byte here
+			unsigned int* digit_counts = counts[d];
+			unsigned int first_byte = (_RadixKey<Key>::encode(key(src[0])) ^ flip) >> (8 * d) & 0xFF;
+			if (digit_counts[first_byte] == size)
+				continue;
+
+			unsigned int offsets[256];
+			unsigned int running_total = 0;
+			for (unsigned int b = 0; b < 256; b++)
+			{
+				offsets[b] = running_total;
+				running_total += digit_counts[b];
+			}
+
+			for (unsigned int i = 0; i < size; i++)
+			{
+				unsigned int byte = (_RadixKey<Key>::encode(key(src[i])) ^ flip) >> (8 * d) & 0xFF;
+				if (dest == scratch && !scratch_constructed)
+					new (dest + offsets[byte]++) T(std::move(src[i]));
+				else
+					dest[offsets[byte]++] = std::move(src[i]);
+			}
+			if (dest == scratch)
+				scratch_constructed = true;
+			std::swap(src, dest);
+		}
+
+		// If the last pass left the values in the scratch buffer, move them home
+		if (src == scratch)
+		{
+			for (unsigned int i = 0; i < size; i++)
+				data[i] = std::move(scratch[i]);
+		}
+		if (scratch_constructed)
+		{
+			for (unsigned int i = 0; i < size; i++)
+				scratch[i].~T();
+		}
+		::operator delete(scratch);
+	}
+
+
+	/// <summary>
+	/// Performs a stable LSD radix sort on an ArrayList of integers, floats or doubles (see the other radix_sort)
+	/// </summary>
+	/// <typeparam name="T">The type of ArrayList we're working on</typeparam>
+	/// <param name="alist">the ArrayList we wish to sort</param>
+	/// <param name="type">The type of sort to perform</param>
+	template <class T>
+	void radix_sort(ArrayList<T>& alist, SortOrder type = SortOrder::ASCENDING)
+	{
+		radix_sort(alist, _RadixIdentity(), type);
 	}
 
 
@@ -154,16 +1034,18 @@ namespace ssuds
 	template <class T>
 	long bubblesort(ArrayList<T>& alist, SortOrder type)
 	{
+		T* data = alist.data();
+		unsigned int size = alist.size();
 		long swaps = 0;
-		for (unsigned int z = 0; z < alist.size(); z++)
+		for (unsigned int z = 0; z < size; z++)
 		{
 			bool sorted = true;
-			for (unsigned int i = 0; i < alist.size() - 1 - z; i++)
+			for (unsigned int i = 0; i + 1 < size - z; i++)
 			{
-				if (_out_of_order(type, alist[i], alist[i + 1]))
+				if (_out_of_order(type, data[i], data[i + 1]))
 				{
 					sorted = false;
-					std::swap(alist[i], alist[i + 1]);
+					std::swap(data[i], data[i + 1]);
 					swaps++;
 				}
 			}
@@ -175,22 +1057,142 @@ namespace ssuds
 
 
 	/// <summary>
-	/// Applies an in-place Fisher-Yates shuffle on the given ArrayList, using the <random> module
+	/// Lists shorter than this are shuffled serially by parallel_shuffle
+	/// </summary>
+	static const unsigned int _parallel_shuffle_cutoff = 1 << 16;
+
+	/// <summary>
+	/// How many chunks / buckets parallel_shuffle uses.  This is fixed (rather than depending on the number of
+	/// threads) so a seed gives the same permutation whatever the pool size.
+	/// </summary>
+	static const unsigned int _parallel_shuffle_blocks = 64;
+
+
+	/// <summary>
+	/// Shuffles [first, last) with Fisher-Yates, drawing the random indices with uniform_below
+	/// </summary>
+	template <class T, class Engine>
+	void _fisher_yates(T* first, T* last, Engine& engine)
+	{
+		// Reference: https://en.wikipedia.org/wiki/Fisher%E2%80%93Yates_shuffle
+		for (std::ptrdiff_t i = last - first - 1; i > 0; i--)
+		{
+			std::uint32_t j = uniform_below(engine, (std::uint32_t)(i + 1));  // generates number in the range 0...i
+			if (j != (std::uint32_t)i)
+				std::swap(first[i], first[j]);
+		}
+	}
+
+
+	/// <summary>
+	/// Applies an in-place Fisher-Yates shuffle on the given ArrayList, using the given random generator (any
+	/// C++ UniformRandomBitGenerator: Xoshiro256, std::mt19937, ...).  The same engine state always gives the
+	/// same permutation.
 	/// </summary>
 	/// <typeparam name="T">The type of ArrayList we're working on</typeparam>
-	/// <param name="alist">the ArrayList we wish to sort</param>
+	/// <typeparam name="Engine">The random generator type</typeparam>
+	/// <param name="alist">the ArrayList we wish to shuffle</param>
+	/// <param name="engine">the random generator (advanced by this call)</param>
+	template <class T, class Engine, typename std::enable_if<!std::is_arithmetic<Engine>::value, int>::type = 0>
+	void shuffle(ArrayList<T>& alist, Engine& engine)
+	{
+		T* data = alist.data();
+		_fisher_yates(data, data + alist.size(), engine);
+	}
+
+
+	/// <summary>
+	/// Applies an in-place Fisher-Yates shuffle on the given ArrayList.  The same seed always gives the same
+	/// permutation.
+	/// </summary>
+	/// <typeparam name="T">The type of ArrayList we're working on</typeparam>
+	/// <param name="alist">the ArrayList we wish to shuffle</param>
+	/// <param name="seed">the random seed</param>
+	template <class T>
+	void shuffle(ArrayList<T>& alist, unsigned long long seed)
+	{
+		Xoshiro256 engine(seed);
+		shuffle(alist, engine);
+	}
+
+
+	/// <summary>
+	/// Applies an in-place Fisher-Yates shuffle on the given ArrayList, with a new random seed every call
+	/// </summary>
+	/// <typeparam name="T">The type of ArrayList we're working on</typeparam>
+	/// <param name="alist">the ArrayList we wish to shuffle</param>
 	template <class T>
 	void shuffle(ArrayList<T>& alist)
 	{
 		// Reference: https://www.cplusplus.com/reference/random/
-		// Reference: https://en.wikipedia.org/wiki/Fisher%E2%80%93Yates_shuffle
-		std::default_random_engine generator;
-		for (int i = alist.size() - 1; i > 0; i--)
+		std::random_device device;
+		shuffle(alist, ((unsigned long long)device() << 32) | device());
+	}
+
+
+	/// <summary>
+	/// Shuffles alist using the threads of pool.  Every value is sent to one of _parallel_shuffle_blocks random
+	/// buckets (one task per chunk of alist), then each bucket is Fisher-Yates shuffled (one task per bucket)
+	/// and the buckets are put back one after the other.  Since each value's bucket is independent and uniform
+	/// and every bucket's order is uniform, so is the whole permutation.  Every chunk and bucket has its own
+	/// random stream derived from seed, so a seed always gives the same permutation, whatever the number of
+	/// threads.  Lists shorter than _parallel_shuffle_cutoff are shuffled serially (which gives a different
+	/// permutation than shuffle(alist, seed) would, but a repeatable one).
+	/// </summary>
+	/// <typeparam name="T">The type of ArrayList we're working on</typeparam>
+	/// <param name="alist">the ArrayList we wish to shuffle</param>
+	/// <param name="seed">the random seed</param>
+	/// <param name="pool">the threads to use</param>
+	template <class T>
+	void parallel_shuffle(ArrayList<T>& alist, unsigned long long seed, ThreadPool& pool)
+	{
+		// Reference: Sanders, "Random Permutations on Distributed, External and Hierarchical Memory" (1998)
+		unsigned int size = alist.size();
+		T* data = alist.data();
+		if (size < _parallel_shuffle_cutoff)
 		{
-			std::uniform_int_distribution<int> distribution(0, i);
-			int j = distribution(generator);  // generates number in the range 0...i
-			
-			std::swap(alist[i], alist[j]);
+			Xoshiro256 engine(seed, 2 * _parallel_shuffle_blocks);
+			_fisher_yates(data, data + size, engine);
+			return;
 		}
+
+		const unsigned int num_blocks = _parallel_shuffle_blocks;
+		std::unique_ptr<unsigned short[]> bucket_of(new unsigned short[size]);
+		std::unique_ptr<unsigned int[]> counts(new unsigned int[num_blocks * num_blocks]());
+		pool.parallel_for(num_blocks, [&](unsigned int chunk, unsigned int)
+		{
+			Xoshiro256 engine(seed, chunk);
+			unsigned int first = (unsigned int)((unsigned long long)size * chunk / num_blocks);
+			unsigned int last = (unsigned int)((unsigned long long)size * (chunk + 1) / num_blocks);
+			unsigned int* chunk_counts = counts.get() + chunk * num_blocks;
+			for (unsigned int i = first; i < last; i++)
+			{
+				unsigned int bucket = uniform_below(engine, num_blocks);
+				bucket_of[i] = (unsigned short)bucket;
+				chunk_counts[bucket]++;
+			}
+		});
+
+		_parallel_bucket_scatter(data, size, bucket_of.get(), counts.get(), num_blocks, num_blocks, pool, [&](unsigned int bucket, T* first, T* last)
+		{
+			Xoshiro256 engine(seed, num_blocks + bucket);
+			_fisher_yates(first, last, engine);
+		});
+	}
+
+
+	/// <summary>
+	/// Shuffles alist with a temporary pool of num_threads threads (see the other parallel_shuffle)
+	/// </summary>
+	/// <param name="alist">the ArrayList we wish to shuffle</param>
+	/// <param name="seed">the random seed</param>
+	/// <param name="num_threads">the number of threads to use (0 = one per hardware thread)</param>
+	template <class T>
+	void parallel_shuffle(ArrayList<T>& alist, unsigned long long seed, unsigned int num_threads = 0)
+	{
+		if (alist.size() < _parallel_shuffle_cutoff)
+			num_threads = 1;
+		ThreadPool pool(num_threads);
+		parallel_shuffle(alist, seed, pool);
 	}
 }
@@ -0,0 +1,719 @@
+#pragma once
+#include <array_list.h>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Define SSUDS_NO_SIMD to use the portable in-node search even where SSE2 is available
+#if !defined(SSUDS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SSUDS_BTREE_SSE2 1
+#include <emmintrin.h>
+#else
+#define SSUDS_BTREE_SSE2 0
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace ssuds
+{
+	/// <summary>
+	/// Counts the sorted keys[0...count-1] that are less than value (i.e. finds value's lower bound in
+	/// the node).  For numbers, a node is small enough that comparing every key without branches (which
+	/// the compiler vectorizes) beats a binary search.
+	/// </summary>
+	template <class T>
+	unsigned int _btree_count_less(const T* keys, unsigned int count, const T& value, std::true_type)
+	{
+		unsigned int result = 0;
+		for (unsigned int i = 0; i < count; i++)
+			result += keys[i] < value ? 1 : 0;
+		return result;
+	}
+
+
+	/// <summary>
+	/// The binary-search version of _btree_count_less for other types (where comparisons are expensive)
+	/// </summary>
+	template <class T>
+	unsigned int _btree_count_less(const T* keys, unsigned int count, const T& value, std::false_type)
+	{
+		unsigned int low = 0, high = count;
+		while (low < high)
+		{
+			unsigned int mid = (low + high) / 2;
+			if (keys[mid] < value)
+				low = mid + 1;
+			else
+				high = mid;
+		}
+		return low;
+	}
+
+
+#if SSUDS_BTREE_SSE2
+	/// <summary>
+	/// The SSE2 version of _btree_count_less for 32-bit keys: compares 8 keys per step.  Since the keys are
+	/// sorted, the "less than" lanes are a prefix, so the first step that isn't all-less ends the search.
+	/// flip is xor-ed into every key (0x80000000 turns an unsigned compare into a signed one).
+	/// </summary>
+	inline unsigned int _btree_count_less_sse2(const int* keys, unsigned int count, int value, int flip)
+	{
+		__m128i flips = _mm_set1_epi32(flip);
+		__m128i target = _mm_set1_epi32(value ^ flip);
+		unsigned int i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i low = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys + i)), flips);
+			__m128i high = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys + i + 4)), flips);
+			// Two mask bits per key
+			unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_packs_epi32(_mm_cmplt_epi32(low, target), _mm_cmplt_epi32(high, target)));
+			if (mask != 0xFFFF)
+			{
+#if defined(_MSC_VER)
+				unsigned long pos;
+				_BitScanForward(&pos, ~mask);
+				return i + (unsigned int)pos / 2;
+#else
+				return i + (unsigned int)__builtin_ctz(~mask) / 2;
+#endif
+			}
+		}
+		for (; i < count; i++)
+		{
+			if ((keys[i] ^ flip) >= (value ^ flip))
+				break;
+		}
+		return i;
+	}
+
+
+	inline unsigned int _btree_count_less(const int* keys, unsigned int count, const int& value, std::true_type)
+	{
+		return _btree_count_less_sse2(keys, count, value, 0);
+	}
+
+
+	inline unsigned int _btree_count_less(const unsigned int* keys, unsigned int count, const unsigned int& value, std::true_type)
+	{
+		return _btree_count_less_sse2((const int*)keys, count, (int)value, (int)0x80000000u);
+	}
+#endif
+
+
+	/// <summary>
+	/// A B-tree based set: an alternative to OrderedSet with the same insert / contains / erase / iteration
+	/// interface.  Rather than one value per node, each node holds up to a few dozen sorted values (and, if
+	/// it isn't a leaf, the pointers to the subtrees between them), sized so the values fill NodeBytes bytes.
+	/// A lookup reads a handful of contiguous nodes instead of chasing one pointer per level, and searches
+	/// within a node with SSE2 for int / unsigned int values.  Every leaf is at the same depth, so the tree is
+	/// always balanced.  T must be default-constructible and comparable with operator<.
+	/// </summary>
+	/// <typeparam name="T">The type of data we'll store in the set</typeparam>
+	/// <typeparam name="NodeBytes">The (approximate) number of bytes of values per node</typeparam>
+	template <class T, unsigned int NodeBytes = 256>
+	class BTreeSet
+	{
+	protected:
+		/// <summary>
+		/// How many values fit in NodeBytes
+		/// </summary>
+		static const unsigned int msKeysThatFit = NodeBytes > 2 * sizeof(unsigned int) ? (unsigned int)((NodeBytes - 2 * sizeof(unsigned int)) / sizeof(T)) : 0;
+
+		/// <summary>
+		/// The most values a node can hold (always odd, so a full node splits into two halves and a middle value)
+		/// </summary>
+		static const unsigned int msMaxKeys = msKeysThatFit < 3 ? 3 : (msKeysThatFit % 2 == 1 ? msKeysThatFit : msKeysThatFit - 1);
+
+		/// <summary>
+		/// The fewest values a node (other than the root) can hold
+		/// </summary>
+		static const unsigned int msMinKeys = msMaxKeys / 2;
+
+		/// <summary>
+		/// A leaf node (and the first part of every internal node)
+		/// </summary>
+		struct node
+		{
+			unsigned int mCount;
+			bool mLeaf;
+			T mKeys[msMaxKeys];
+
+			node(bool leaf) : mCount(0), mLeaf(leaf)
+			{
+				// empty, on purpose
+			}
+		};
+
+		/// <summary>
+		/// An internal node: mChildren[i] holds the values between mKeys[i - 1] and mKeys[i]
+		/// </summary>
+		struct inner_node : public node
+		{
+			node* mChildren[msMaxKeys + 1];
+
+			inner_node() : node(false)
+			{
+				// empty, on purpose
+			}
+		};
+
+		/// <summary>
+		/// The root node, or nullptr if the set is empty
+		/// </summary>
+		node* mRoot;
+
+		/// <summary>
+		/// Number of values in the set
+		/// </summary>
+		unsigned int mSize;
+
+	public:
+		/// <summary>
+		/// This class is used to iterate (in order) through a BTreeSet instance.  It keeps the path from the
+		/// root to the current value.
+		/// </summary>
+		class BTreeSetIterator
+		{
+		protected:
+			/// <summary>
+			/// One step of the path: a node and the index of the value we're on (for the last step) or of the
+			/// child we went down into (which is also the next value to visit in that node)
+			/// </summary>
+			struct step
+			{
+				const node* mNode;
+				unsigned int mIndex;
+			};
+
+			/// <summary>
+			/// The path from the root (empty for the end iterator)
+			/// </summary>
+			ArrayList<step> mPath;
+
+		public:
+			/// <summary>
+			/// Default constructor (an end iterator)
+			/// </summary>
+			BTreeSetIterator()
+			{
+				// empty, on purpose
+			}
+
+
+			/// <summary>
+			/// Constructor
+			/// </summary>
+			/// <param name="root">the root to start at (or nullptr for an end iterator)</param>
+			BTreeSetIterator(const node* root)
+			{
+				if (root && root->mCount > 0)
+					descend_leftmost(root);
+			}
+
+			/// <summary>
+			/// Gets the current value of the iterator
+			/// </summary>
+			/// <returns>the current value</returns>
+			const T& operator*() const
+			{
+				if (mPath.size() == 0)
+					throw std::invalid_argument("iterator is not in a proper state!");
+				const step& top = mPath[mPath.size() - 1];
+				return top.mNode->mKeys[top.mIndex];
+			}
+
+			/// <summary>
+			/// Advances the iteration
+			/// </summary>
+			void operator++()
+			{
+				step& top = mPath[mPath.size() - 1];
+				top.mIndex++;
+				if (!top.mNode->mLeaf)
+				{
+					// The next value is the smallest one in the subtree after the current value
+					descend_leftmost(static_cast<const inner_node*>(top.mNode)->mChildren[top.mIndex]);
+					return;
+				}
+
+				// Back up until we find a node that still has values left
+				while (mPath.size() > 0 && mPath[mPath.size() - 1].mIndex >= mPath[mPath.size() - 1].mNode->mCount)
+					mPath.remove(mPath.size() - 1, false);
+			}
+
+			/// <summary>
+			/// Returns true if two iterators are on the same value
+			/// </summary>
+			bool operator==(const BTreeSetIterator& other) const
+			{
+				if (mPath.size() == 0 || other.mPath.size() == 0)
+					return mPath.size() == other.mPath.size();
+				const step& a = mPath[mPath.size() - 1];
+				const step& b = other.mPath[other.mPath.size() - 1];
+				return a.mNode == b.mNode && a.mIndex == b.mIndex;
+			}
+
+			/// <summary>
+			/// Returns true if two iterators are unlike each other
+			/// </summary>
+			bool operator!=(const BTreeSetIterator& other) const
+			{
+				return !(*this == other);
+			}
+
+		protected:
+			/// <summary>
+			/// Walks down the left edge of a subtree, adding each node to the path
+			/// </summary>
+			void descend_leftmost(const node* cur)
+			{
+				while (true)
+				{
+					step s = { cur, 0 };
+					mPath.append(s);
+					if (cur->mLeaf)
+						break;
+					cur = static_cast<const inner_node*>(cur)->mChildren[0];
+				}
+			}
+		};
+
+
+		/// Constructor
+		BTreeSet() : mRoot(nullptr), mSize(0)
+		{
+			// empty, on purpose
+		}
+
+
+		/// <summary>
+		/// Copy-constructor
+		/// </summary>
+		/// <param name="other">the set we wish to copy</param>
+		BTreeSet(const BTreeSet& other) : mRoot(other.mRoot ? copy_node(other.mRoot) : nullptr), mSize(other.mSize)
+		{
+			// empty, on purpose
+		}
+
+
+		/// <summary>
+		/// The initializer-list constructor
+		/// </summary>
+		/// <param name="ilist">contains the initial data</param>
+		BTreeSet(const std::initializer_list<T>& ilist) : mRoot(nullptr), mSize(0)
+		{
+			for (const T& val : ilist)
+				insert(val);
+		}
+
+
+		/// <summary>
+		/// The move-constructor
+		/// </summary>
+		/// <param name="other">the set we are stealing data from</param>
+		BTreeSet(BTreeSet&& other) : mRoot(other.mRoot), mSize(other.mSize)
+		{
+			other.mRoot = nullptr;
+			other.mSize = 0;
+		}
+
+
+		/// Destructor
+		~BTreeSet()
+		{
+			clear();
+		}
+
+
+		/// <summary>
+		/// Makes us a copy of the other set
+		/// </summary>
+		/// <param name="other">the set we wish to copy</param>
+		/// <returns>A reference to us</returns>
+		BTreeSet& operator=(const BTreeSet& other)
+		{
+			if (this != &other)
+			{
+				clear();
+				mRoot = other.mRoot ? copy_node(other.mRoot) : nullptr;
+				mSize = other.mSize;
+			}
+			return *this;
+		}
+
+
+		/// <summary>
+		/// Create an iterator that is "pointing" to the first (lowest) element
+		/// </summary>
+		/// <returns>A valid iterator if the set is non-empty, or the end iterator if not</returns>
+		BTreeSetIterator begin() const
+		{
+			return BTreeSetIterator(mRoot);
+		}
+
+
+		/// <summary>
+		/// Returns a special iterator which marks the end of iteration
+		/// </summary>
+		/// <returns>An end iterator</returns>
+		BTreeSetIterator end() const
+		{
+			return BTreeSetIterator(nullptr);
+		}
+
+
+		/// <summary>
+		///  Removes all elements from the set and returns it to its original state
+		/// </summary>
+		void clear()
+		{
+			if (mRoot)
+				delete_node(mRoot);
+			mRoot = nullptr;
+			mSize = 0;
+		}
+
+
+		/// <summary>
+		/// Determines if the given value is in the set or not
+		/// </summary>
+		/// <param name="val">value we're looking for</param>
+		/// <returns>true if it's in the set, false if not</returns>
+		bool contains(const T& val) const
+		{
+			const node* cur = mRoot;
+			while (cur)
+			{
+				unsigned int i = find_in_node(cur, val);
+				if (i < cur->mCount && !(val < cur->mKeys[i]))
+					return true;
+				if (cur->mLeaf)
+					return false;
+				cur = static_cast<const inner_node*>(cur)->mChildren[i];
+			}
+			return false;
+		}
+
+
+		/// <summary>
+		/// Inserts a new element into the set
+		/// </summary>
+		/// <param name="val">the new value to add</param>
+		/// <returns>true if a new value was added</returns>
+		bool insert(const T& val)
+		{
+			// Reference: Cormen et al., "Introduction to Algorithms", ch. 18 (full nodes are split on the way
+			// down, so there is always room for a value that comes up from a split)
+			if (!mRoot)
+				mRoot = new node(true);
+			if (mRoot->mCount == msMaxKeys)
+			{
+				inner_node* new_root = new inner_node();
+				new_root->mChildren[0] = mRoot;
+				mRoot = new_root;
+				split_child(new_root, 0);
+			}
+
+			node* cur = mRoot;
+			while (true)
+			{
+				unsigned int i = find_in_node(cur, val);
+				if (i < cur->mCount && !(val < cur->mKeys[i]))
+					return false;
+				if (cur->mLeaf)
+				{
+					for (unsigned int j = cur->mCount; j > i; j--)
+						cur->mKeys[j] = std::move(cur->mKeys[j - 1]);
+					cur->mKeys[i] = val;
+					cur->mCount++;
+					mSize++;
+					return true;
+				}
+
+				inner_node* inner = static_cast<inner_node*>(cur);
+				if (inner->mChildren[i]->mCount == msMaxKeys)
+				{
+					split_child(inner, i);
+					if (inner->mKeys[i] < val)
+						i++;
+					else if (!(val < inner->mKeys[i]))
+						return false;
+				}
+				cur = inner->mChildren[i];
+			}
+		}
+
+
+		/// <summary>
+		/// Removes an element (if it exists) from the set
+		/// </summary>
+		/// <param name="val">the value to remove</param>
+		/// <returns>true if that item was removed, false if it wasn't in the set</returns>
+		bool erase(const T& val)
+		{
+			if (!mRoot)
+				return false;
+			bool result = erase_from(mRoot, val);
+			if (mRoot->mCount == 0)
+			{
+				// The root ran out of values: its only child (if any) becomes the root
+				node* old_root = mRoot;
+				mRoot = old_root->mLeaf ? nullptr : static_cast<inner_node*>(old_root)->mChildren[0];
+				if (old_root->mLeaf)
+					delete old_root;
+				else
+					delete static_cast<inner_node*>(old_root);
+			}
+			if (result)
+				mSize--;
+			return result;
+		}
+
+
+		/// <summary>
+		/// Gets the height of this tree (1 if we just have the root)
+		/// </summary>
+		/// <returns>the number of levels</returns>
+		unsigned int get_height() const
+		{
+			unsigned int height = 0;
+			for (const node* cur = mRoot; cur; cur = cur->mLeaf ? nullptr : static_cast<const inner_node*>(cur)->mChildren[0])
+				height++;
+			return height;
+		}
+
+
+		/// <summary>
+		/// Returns the number of elements in a set
+		/// </summary>
+		/// <returns>the size</returns>
+		unsigned int size() const
+		{
+			return mSize;
+		}
+
+
+		/// <summary>
+		/// Returns the most values one node can hold
+		/// </summary>
+		/// <returns>the node capacity</returns>
+		static unsigned int node_capacity()
+		{
+			return msMaxKeys;
+		}
+
+	protected:
+		/// <summary>
+		/// Finds the index of the first value in n that isn't less than val
+		/// </summary>
+		static unsigned int find_in_node(const node* n, const T& val)
+		{
+			return _btree_count_less(n->mKeys, n->mCount, val, typename std::is_arithmetic<T>::type());
+		}
+
+
+		/// <summary>
+		/// Splits parent's full child i into two nodes of msMinKeys values, moving the middle value up into parent
+		/// (which must not be full)
+		/// </summary>
+		void split_child(inner_node* parent, unsigned int i)
+		{
+			node* left = parent->mChildren[i];
+			node* right = left->mLeaf ? new node(true) : new inner_node();
+			for (unsigned int j = 0; j < msMinKeys; j++)
+				right->mKeys[j] = std::move(left->mKeys[msMinKeys + 1 + j]);
+			if (!left->mLeaf)
+			{
+				for (unsigned int j = 0; j <= msMinKeys; j++)
+					static_cast<inner_node*>(right)->mChildren[j] = static_cast<inner_node*>(left)->mChildren[msMinKeys + 1 + j];
+			}
+			right->mCount = msMinKeys;
+			left->mCount = msMinKeys;
+
+			for (unsigned int j = parent->mCount; j > i; j--)
+			{
+				parent->mKeys[j] = std::move(parent->mKeys[j - 1]);
+				parent->mChildren[j + 1] = parent->mChildren[j];
+			}
+			parent->mKeys[i] = std::move(left->mKeys[msMinKeys]);
+			parent->mChildren[i + 1] = right;
+			parent->mCount++;
+		}
+
+
+		/// <summary>
+		/// Merges parent's child i + 1 (and the value between them) into child i.  Both children must have
+		/// msMinKeys values.
+		/// </summary>
+		void merge_children(inner_node* parent, unsigned int i)
+		{
+			node* left = parent->mChildren[i];
+			node* right = parent->mChildren[i + 1];
+			left->mKeys[left->mCount] = std::move(parent->mKeys[i]);
+			for (unsigned int j = 0; j < right->mCount; j++)
+				left->mKeys[left->mCount + 1 + j] = std::move(right->mKeys[j]);
+			if (!left->mLeaf)
+			{
+				for (unsigned int j = 0; j <= right->mCount; j++)
+					static_cast<inner_node*>(left)->mChildren[left->mCount + 1 + j] = static_cast<inner_node*>(right)->mChildren[j];
+			}
+			left->mCount += right->mCount + 1;
+
+			for (unsigned int j = i; j + 1 < parent->mCount; j++)
+			{
+				parent->mKeys[j] = std::move(parent->mKeys[j + 1]);
+				parent->mChildren[j + 1] = parent->mChildren[j + 2];
+			}
+			parent->mCount--;
+
+			if (right->mLeaf)
+				delete right;
+			else
+				delete static_cast<inner_node*>(right);
+		}
+
+
+		/// <summary>
+		/// Makes sure parent's child i has more than msMinKeys values (so a value can be removed from it), by
+		/// borrowing a value from a sibling or merging with one
+		/// </summary>
+		/// <returns>the index of the child that now holds child i's values</returns>
+		unsigned int fill_child(inner_node* parent, unsigned int i)
+		{
+			node* child = parent->mChildren[i];
+			if (i > 0 && parent->mChildren[i - 1]->mCount > msMinKeys)
+			{
+				// Rotate a value from the left sibling through the parent
+				node* sibling = parent->mChildren[i - 1];
+				for (unsigned int j = child->mCount; j > 0; j--)
+					child->mKeys[j] = std::move(child->mKeys[j - 1]);
+				child->mKeys[0] = std::move(parent->mKeys[i - 1]);
+				parent->mKeys[i - 1] = std::move(sibling->mKeys[sibling->mCount - 1]);
+				if (!child->mLeaf)
+				{
+					inner_node* inner_child = static_cast<inner_node*>(child);
+					for (unsigned int j = child->mCount + 1; j > 0; j--)
+						inner_child->mChildren[j] = inner_child->mChildren[j - 1];
+					inner_child->mChildren[0] = static_cast<inner_node*>(sibling)->mChildren[sibling->mCount];
+				}
+				child->mCount++;
+				sibling->mCount--;
+				return i;
+			}
+			if (i < parent->mCount && parent->mChildren[i + 1]->mCount > msMinKeys)
+			{
+				// Rotate a value from the right sibling through the parent
+				node* sibling = parent->mChildren[i + 1];
+				child->mKeys[child->mCount] = std::move(parent->mKeys[i]);
+				parent->mKeys[i] = std::move(sibling->mKeys[0]);
+				for (unsigned int j = 0; j + 1 < sibling->mCount; j++)
+					sibling->mKeys[j] = std::move(sibling->mKeys[j + 1]);
+				if (!child->mLeaf)
+				{
+					inner_node* inner_sibling = static_cast<inner_node*>(sibling);
+					static_cast<inner_node*>(child)->mChildren[child->mCount + 1] = inner_sibling->mChildren[0];
+					for (unsigned int j = 0; j < sibling->mCount; j++)
+						inner_sibling->mChildren[j] = inner_sibling->mChildren[j + 1];
+				}
+				child->mCount++;
+				sibling->mCount--;
+				return i;
+			}
+			if (i < parent->mCount)
+			{
+				merge_children(parent, i);
+				return i;
+			}
+			merge_children(parent, i - 1);
+			return i - 1;
+		}
+
+
+		/// <summary>
+		/// Removes val from the subtree rooted at cur.  cur has more than msMinKeys values (or is the root), so
+		/// it can always lose one.
+		/// </summary>
+		/// <returns>true if val was found</returns>
+		bool erase_from(node* cur, const T& val)
+		{
+			// Reference: Cormen et al., "Introduction to Algorithms", ch. 18
+			while (true)
+			{
+				unsigned int i = find_in_node(cur, val);
+				bool here = i < cur->mCount && !(val < cur->mKeys[i]);
+				if (cur->mLeaf)
+				{
+					if (!here)
+						return false;
+					for (unsigned int j = i; j + 1 < cur->mCount; j++)
+						cur->mKeys[j] = std::move(cur->mKeys[j + 1]);
+					cur->mCount--;
+					return true;
+				}
+
+				inner_node* inner = static_cast<inner_node*>(cur);
+				if (here)
+				{
+					// Replace the value with its predecessor or successor (from a child that can spare one),
+					// or merge the two children around it and remove it from the result
+					if (inner->mChildren[i]->mCount > msMinKeys)
+					{
+						node* pred = inner->mChildren[i];
+						while (!pred->mLeaf)
+							pred = static_cast<inner_node*>(pred)->mChildren[pred->mCount];
+						inner->mKeys[i] = pred->mKeys[pred->mCount - 1];
+						return erase_from(inner->mChildren[i], inner->mKeys[i]);
+					}
+					if (inner->mChildren[i + 1]->mCount > msMinKeys)
+					{
+						node* succ = inner->mChildren[i + 1];
+						while (!succ->mLeaf)
+							succ = static_cast<inner_node*>(succ)->mChildren[0];
+						inner->mKeys[i] = succ->mKeys[0];
+						return erase_from(inner->mChildren[i + 1], inner->mKeys[i]);
+					}
+					merge_children(inner, i);
+					cur = inner->mChildren[i];
+					continue;
+				}
+
+				if (inner->mChildren[i]->mCount <= msMinKeys)
+					i = fill_child(inner, i);
+				cur = inner->mChildren[i];
+			}
+		}
+
+
+		/// <summary>
+		/// Makes a deep copy of a subtree
+		/// </summary>
+		static node* copy_node(const node* n)
+		{
+			if (n->mLeaf)
+				return new node(*n);
+			inner_node* result = new inner_node(*static_cast<const inner_node*>(n));
+			for (unsigned int i = 0; i <= n->mCount; i++)
+				result->mChildren[i] = copy_node(result->mChildren[i]);
+			return result;
+		}
+
+
+		/// <summary>
+		/// Deletes a subtree (the recursion is only as deep as the tree, which is very shallow)
+		/// </summary>
+		static void delete_node(node* n)
+		{
+			if (n->mLeaf)
+			{
+				delete n;
+				return;
+			}
+			inner_node* inner = static_cast<inner_node*>(n);
+			for (unsigned int i = 0; i <= inner->mCount; i++)
+				delete_node(inner->mChildren[i]);
+			delete inner;
+		}
+	};
+}
@@ -0,0 +1,174 @@
+#pragma once
+#include <array_list.h>
+#include <array_list_utility.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace ssuds
+{
+	/// <summary>
+	/// A read-only search structure built from a sorted ArrayList, for lookup tables that are searched far
+	/// more often than they change (e.g. remapping node ids).  The values are stored in Eytzinger (BFS heap)
+	/// order: the root is at slot 1 and the children of slot k are at 2k and 2k+1.  A search just walks down
+	/// from the root, so the first few levels that every search touches share a few cache lines, each step is
+	/// branchless, and since the 16 descendants four levels down sit next to each other, they can be
+	/// prefetched with one or two cache lines.
+	/// </summary>
+	/// <typeparam name="T">The type of the values</typeparam>
+	/// <typeparam name="Compare">The order the source list is sorted in (SortAscending or SortDescending)</typeparam>
+	template <class T, class Compare = SortAscending>
+	class EytzingerIndex
+	{
+	protected:
+		/// <summary>
+		/// The values in Eytzinger order (slot 0 is unused, and holds a copy of the first value; the list is
+		/// empty if the index is)
+		/// </summary>
+		ArrayList<T> mTree;
+
+		/// <summary>
+		/// The index in the source list of the value in each slot of mTree (always size() + 1 long)
+		/// </summary>
+		ArrayList<unsigned int> mRanks;
+
+		/// <summary>
+		/// The comparator
+		/// </summary>
+		Compare mComp;
+
+	public:
+		/// <summary>
+		/// Builds an index over a sorted list (which is copied, so later changes to it are not seen)
+		/// </summary>
+		/// <param name="sorted">a list sorted according to Compare</param>
+		/// <param name="comp">the comparator</param>
+		EytzingerIndex(const ArrayList<T>& sorted, Compare comp = Compare()) : mComp(comp)
+		{
+			unsigned int size = sorted.size();
+			mRanks.reserve(size + 1);
+			for (unsigned int i = 0; i <= size; i++)
+				mRanks.append(0);
+			build(0, 1);
+
+			// Copy the values straight into their slots, so T needs nothing more than a copy constructor
+			if (size > 0)
+			{
+				mTree.reserve(size + 1);
+				for (unsigned int slot = 0; slot <= size; slot++)
+					mTree.append(sorted[mRanks[slot]]);
+			}
+		}
+
+
+		/// <summary>
+		/// Returns the number of values in the index
+		/// </summary>
+		/// <returns>the size</returns>
+		unsigned int size() const
+		{
+			return mRanks.size() - 1;
+		}
+
+
+		/// <summary>
+		/// Finds the first value (in the source list's order) that doesn't belong before value
+		/// </summary>
+		/// <param name="value">the value to search for</param>
+		/// <param name="num_ops">If not nullptr, the number of comparisons performed is written here</param>
+		/// <returns>its index in the source list (size() if there is none)</returns>
+		unsigned int lower_bound(const T& value, unsigned long* num_ops = nullptr) const
+		{
+			unsigned int slot = lower_bound_slot(value, num_ops);
+			return slot == 0 ? size() : mRanks[slot];
+		}
+
+
+		/// <summary>
+		/// Finds a value
+		/// </summary>
+		/// <param name="value">the value to search for</param>
+		/// <param name="num_ops">If not nullptr, the number of comparisons performed is written here</param>
+		/// <returns>the index of its first occurrence in the source list (or -1 if it isn't there)</returns>
+		int find(const T& value, unsigned long* num_ops = nullptr) const
+		{
+			unsigned int slot = lower_bound_slot(value, num_ops);
+			if (slot == 0 || mComp(value, mTree[slot]))
+				return -1;
+			return (int)mRanks[slot];
+		}
+
+
+		/// <summary>
+		/// Is value in the index?
+		/// </summary>
+		/// <param name="value">the value to search for</param>
+		/// <returns>true if it is present</returns>
+		bool contains(const T& value) const
+		{
+			return find(value) >= 0;
+		}
+
+	protected:
+		/// <summary>
+		/// Gives the subtree rooted at slot the source indices next, next + 1, ... (an in-order traversal of
+		/// the implicit tree).  The recursion is only log2(n) deep.
+		/// </summary>
+		/// <returns>the next unused source index</returns>
+		unsigned int build(unsigned int next, unsigned int slot)
+		{
+			if (slot < mRanks.size())
+			{
+				next = build(next, 2 * slot);
+				mRanks[slot] = next;
+				next = build(next + 1, 2 * slot + 1);
+			}
+			return next;
+		}
+
+
+		/// <summary>
+		/// The search: go right while the slot's value belongs before value, left otherwise.  The answer is
+		/// the last slot where we went left, which is found by dropping the trailing right-turns (1 bits) and
+		/// that left-turn from the final slot number.
+		/// </summary>
+		/// <returns>the slot of the lower bound (0 if there is none)</returns>
+		unsigned int lower_bound_slot(const T& value, unsigned long* num_ops) const
+		{
+			const T* tree = mTree.data();
+			unsigned int num_slots = mTree.size();
+			unsigned int prefetch_stride = 64 / sizeof(T) > 0 ? 64 / sizeof(T) : 1;
+			unsigned long comparisons = 0;
+			unsigned int slot = 1;
+			while (slot < num_slots)
+			{
+				unsigned int ahead = slot * 16;
+				SSUDS_PREFETCH(tree + (ahead < num_slots ? ahead : 0));
+				SSUDS_PREFETCH(tree + (ahead + prefetch_stride < num_slots ? ahead + prefetch_stride : 0));
+				slot = 2 * slot + (mComp(tree[slot], value) ? 1 : 0);
+				comparisons++;
+			}
+			if (num_ops != nullptr)
+				*num_ops = comparisons;
+			unsigned int shift = trailing_ones(slot) + 1;
+			return shift < 32 ? slot >> shift : 0;
+		}
+
+
+		/// <summary>
+		/// Counts the 1 bits at the bottom of bits
+		/// </summary>
+		static unsigned int trailing_ones(unsigned int bits)
+		{
+			if (~bits == 0)
+				return 32;
+#if defined(_MSC_VER)
+			unsigned long pos;
+			_BitScanForward(&pos, ~bits);
+			return (unsigned int)pos;
+#else
+			return (unsigned int)__builtin_ctz(~bits);
+#endif
+		}
+	};
+}
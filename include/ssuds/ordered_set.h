@@ -1,7 +1,6 @@
 #pragma once
 #include <array_list.h>
 #include <sstream>
-#include <stack.h>
 #include <iostream>
 
 namespace ssuds
@@ -11,15 +10,21 @@ namespace ssuds
 
 	/// <summary>
 	/// An ordered set is a collection of unique values with the ability to access those
-	/// values in-order (plus a few other ways)
+	/// values in-order (plus a few other ways).  The tree is an AVL tree: after every insert and
+	/// erase, any node whose subtrees' heights differ by more than one is fixed with a rotation, so
+	/// the height stays below 1.44 * log2(n + 2) and every operation is O(log n) -- even if the values
+	/// arrive in sorted order.  Each node also knows the size of its subtree, so rank / select and range
+	/// queries don't need a full traversal.
 	/// </summary>
 	/// <typeparam name="T">The type of data we'll store in the set</typeparam>
 	template <class T>
 	class OrderedSet
 	{
 		/// <summary>
-		/// In this implementation, the node is where most of the work happens.  All methods
-		/// are coded recursively
+		/// In this implementation, the node is where most of the work happens.  Insert, erase and
+		/// contains are coded recursively (the tree is balanced, so the recursion is only O(log n) deep).
+		/// Anything that visits every node (teardown, traversals, iteration) walks the tree with the parent
+		/// pointers instead, so it needs no stack at all.
 		/// </summary>
 		class node
 		{
@@ -27,32 +32,96 @@ namespace ssuds
 			T mData;
 			node* mLeft;
 			node* mRight;
+
+			/// Our parent (nullptr for the root)
+			node* mParent;
+
+			/// The height of the subtree rooted here (1 for a leaf)
+			int mHeight;
+
+			/// The number of nodes in the subtree rooted here (1 for a leaf).  This is what lets the set
+			/// find a value by its rank, or the rank of a value, in O(log n)
+			unsigned int mCount;
 	
 			/// Constructor
-			node(T val) : mData(val), mLeft(nullptr), mRight(nullptr)
+			node(T val, node* parent = nullptr) : mData(val), mLeft(nullptr), mRight(nullptr), mParent(parent), mHeight(1), mCount(1)
 			{
 				// empty, on purpose
 			}
 
 
-			/// Destructor
-			~node()
+			/// <summary>
+			/// Sets our left child (which may be nullptr), pointing it back at us
+			/// </summary>
+			void set_left(node* child)
 			{
-				// Delete my children (note: i've come to realize [thanks, Zach Kerner!] that calling
-				/// delete on a null-pointer is allowed (it does nothing)
-				delete mLeft;
-				delete mRight;
+				mLeft = child;
+				if (child)
+					child->mParent = this;
+			}
+
+
+			/// <summary>
+			/// Sets our right child (which may be nullptr), pointing it back at us
+			/// </summary>
+			void set_right(node* child)
+			{
+				mRight = child;
+				if (child)
+					child->mParent = this;
+			}
+
+
+			/// <summary>
+			/// Finds the lowest node of the subtree rooted at n
+			/// </summary>
+			static node* leftmost(node* n)
+			{
+				while (n && n->mLeft)
+					n = n->mLeft;
+				return n;
+			}
+
 
-				// Nothing else to do!  Someone else has deleted me (which is how I got here)
+			/// <summary>
+			/// Finds the node that comes after n in the whole tree (an in-order step): the lowest node of
+			/// n's right subtree if it has one, otherwise the first ancestor we reach from its left side
+			/// </summary>
+			/// <returns>the next node, or nullptr if n is the highest</returns>
+			static node* next_in_order(node* n)
+			{
+				if (n->mRight)
+					return leftmost(n->mRight);
+				while (n->mParent && n == n->mParent->mRight)
+					n = n->mParent;
+				return n->mParent;
 			}
 
+
 			/// <summary>
-			/// Clears the children pointers without deleting them (useful if we want to destroy just
-			/// a node)
+			/// Deletes every node of the subtree rooted at n without recursing: while the current node has
+			/// a left child, a right rotation moves that child up; once it has none, it is deleted and we
+			/// move on to its right child.  Each rotation puts one more node on the left-free "spine", so
+			/// this is O(n).
 			/// </summary>
-			void clear_children()
+			static void destroy_subtree(node* n)
 			{
-				mLeft = mRight = nullptr;
+				while (n)
+				{
+					if (n->mLeft)
+					{
+						node* left = n->mLeft;
+						n->mLeft = left->mRight;
+						left->mRight = n;
+						n = left;
+					}
+					else
+					{
+						node* right = n->mRight;
+						delete n;
+						n = right;
+					}
+				}
 			}
 
 			/// <summary>
@@ -74,85 +143,50 @@ namespace ssuds
 
 
 			/// <summary>
-			/// Removes the given element from this sub-tree, if it exists
+			/// Removes the given element from this sub-tree, if it exists.  If this node is the one
+			/// removed, it deletes itself.
 			/// </summary>
 			/// <param name="val">the value to remove</param>
-			/// <returns>the new value this node should be set to</returns>
+			/// <param name="found">set to true if the value was found</param>
+			/// <returns>the new root of this sub-tree (the caller should store it in place of this node)</returns>
 			node* erase_recursive(const T& val, bool& found)
 			{
-				// Do we contain the data to remove?
-				if (mData == val)
-				{
-					found = true;
-
-					// Are we a leaf node
-					if (mLeft == nullptr && mRight == nullptr)
-					{
-						// We are a leaf -- signal to the caller that they should destroy us and set that
-						// child to null
-						return nullptr;
-					}
-					else if (mLeft == nullptr || mRight == nullptr)
-					{
-						// We are not a leaf, but contain just one child -- return the value of our child
-						// -- the caller should destroy our node
-						if (mLeft != nullptr)
-							return mLeft;
-						else
-							return mRight;
-					}
-					else
-					{
-						// The more difficult case -- we have two children
-						node* successor = find_successor();			// should never be null based on our
-																	// if check's above
-						mData = successor->mData;					// We now (for a moment) have two copies
-																	// of that value in our set.
-
-						// This will remove the DUPLICATE value.
-						node* result = mRight->erase_recursive(mData, found);				
-						if (result != mRight)
-						{
-							mRight->clear_children();
-							delete mRight;
-							mRight = result;
-						}
-
-						// We return ourself because we don't actually want to destroy any nodes (other than the
-						// one that should've been destroyed
-						return this;
-					}
-				}
-				else if (mLeft && val < mData)
+				if (val < mData)
 				{
 					// Tell our left child to attempt to erase it
-					node* result = mLeft->erase_recursive(val, found);
-					if (result != mLeft && found)
-					{
-						mLeft->clear_children();
-						delete mLeft;
-						mLeft = result;
-					}
-					return this;
+					if (mLeft)
+						set_left(mLeft->erase_recursive(val, found));
 				}
-				else if (mRight && val > mData)
+				else if (val > mData)
 				{
 					// Tell our right child to attempt to erase it
-					node* result = mRight->erase_recursive(val, found);
-					if (result != mRight && found)
-					{
-						mRight->clear_children();
-						delete mRight;
-						mRight = result;
-					}
-					return this;
+					if (mRight)
+						set_right(mRight->erase_recursive(val, found));
+				}
+				else if (mLeft == nullptr || mRight == nullptr)
+				{
+					// We contain the data to remove, and have at most one child.  That child (or nullptr
+					// if we are a leaf) takes our place
+					found = true;
+					node* replacement = mLeft != nullptr ? mLeft : mRight;
+					if (replacement)
+						replacement->mParent = mParent;
+					delete this;
+					return replacement;
 				}
 				else
 				{
-					// We don't have the value!
-					found = false;
-					return this;
+					// The more difficult case -- we have two children
+					found = true;
+					node* successor = find_successor();			// should never be null based on our
+																// if check's above
+					mData = successor->mData;					// We now (for a moment) have two copies
+																// of that value in our set.
+
+					// This will remove the DUPLICATE value.
+					set_right(mRight->erase_recursive(mData, found));
 				}
+				return rebalance();
 			}
 
 
@@ -176,41 +210,95 @@ namespace ssuds
 
 
 			/// <summary>
-			/// Used to generate a text-visualization of this node and its descendents of this form
-			///         [my_data]      (shows more whitespace for deeper nodes)
-			///             L: [my-left-child]
-			///               ...
-			///             R: [my-right-child]
-			///               ...
+			/// Gets the height of a (possibly empty) subtree
 			/// </summary>
-			/// <param name="ss">a reference to a string-stream which is added to by this method</param>
-			/// <param name="recursion_depth">controls the amount of whitespace before my data</param>
-			/// <param name="prefix">a label to put before my data (generally "", "L: ", or "R: ")</param>
-			void generate_string_recursive(std::stringstream& ss, int recursion_depth, std::string prefix)
-			{
-				for (int i = 0; i < recursion_depth; i++)
-					ss << "   ";
-				ss << prefix << mData << std::endl;
-				if (mLeft)
-					mLeft->generate_string_recursive(ss, recursion_depth + 1, "L: ");
-				if (mRight)
-					mRight->generate_string_recursive(ss, recursion_depth + 1, "R: ");
+			/// <param name="n">the subtree's root (or nullptr)</param>
+			/// <returns>its height (0 if empty)</returns>
+			static int height(const node* n)
+			{
+				return n ? n->mHeight : 0;
 			}
 
 
 			/// <summary>
-			/// Gets the height of this tree (1 if we just have the root)
+			/// Gets the number of nodes in a (possibly empty) subtree
 			/// </summary>
-			/// <returns></returns>
-			unsigned int get_height_recursive() const
+			/// <param name="n">the subtree's root (or nullptr)</param>
+			/// <returns>its node count (0 if empty)</returns>
+			static unsigned int count(const node* n)
 			{
-				unsigned int left_ht = 0, right_ht = 0;
-				if (mLeft)
-					left_ht = mLeft->get_height_recursive();
-				if (mRight)
-					right_ht = mRight->get_height_recursive();
-				
-				return (left_ht > right_ht ? left_ht : right_ht) + 1;
+				return n ? n->mCount : 0;
+			}
+
+
+			/// <summary>
+			/// Recomputes our height and node count from our children's
+			/// </summary>
+			void update_stats()
+			{
+				int left_ht = height(mLeft), right_ht = height(mRight);
+				mHeight = (left_ht > right_ht ? left_ht : right_ht) + 1;
+				mCount = count(mLeft) + count(mRight) + 1;
+			}
+
+
+			/// <summary>
+			/// Rotates this subtree to the left: our right child becomes its root and we become its left child
+			/// </summary>
+			/// <returns>the new root of this subtree</returns>
+			node* rotate_left()
+			{
+				node* new_root = mRight;
+				new_root->mParent = mParent;
+				set_right(new_root->mLeft);
+				new_root->set_left(this);
+				update_stats();
+				new_root->update_stats();
+				return new_root;
+			}
+
+
+			/// <summary>
+			/// Rotates this subtree to the right: our left child becomes its root and we become its right child
+			/// </summary>
+			/// <returns>the new root of this subtree</returns>
+			node* rotate_right()
+			{
+				node* new_root = mLeft;
+				new_root->mParent = mParent;
+				set_left(new_root->mRight);
+				new_root->set_right(this);
+				update_stats();
+				new_root->update_stats();
+				return new_root;
+			}
+
+
+			/// <summary>
+			/// Called after a child subtree changed (by one level at most): updates our height and, if our
+			/// subtrees' heights now differ by two, restores the AVL property with a single or double rotation
+			/// </summary>
+			/// <returns>the new root of this subtree</returns>
+			node* rebalance()
+			{
+				update_stats();
+				int balance = height(mLeft) - height(mRight);
+				if (balance > 1)
+				{
+					// Left-heavy.  If the extra height is in our left child's right subtree, we need a
+					// double (left-right) rotation
+					if (height(mLeft->mLeft) < height(mLeft->mRight))
+						set_left(mLeft->rotate_left());
+					return rotate_right();
+				}
+				else if (balance < -1)
+				{
+					// Right-heavy (the mirror image)
+					if (height(mRight->mRight) < height(mRight->mLeft))
+						set_right(mRight->rotate_right());
+					return rotate_left();
+				}
+				return this;
 			}
 
 
@@ -219,54 +307,86 @@ namespace ssuds
 			/// does nothing
 			/// </summary>
 			/// <param name="val">The new value to insert</param>
-			/// <returns>the number of new nodes created (0 or 1)</returns>
-			int insert_recursive(const T& val)
+			/// <param name="num_added">set to the number of new nodes created (0 or 1)</param>
+			/// <returns>the new root of this sub-tree (the caller should store it in place of this node)</returns>
+			node* insert_recursive(const T& val, int& num_added)
 			{
 				if (val < mData)
 				{
 					if (mLeft)
-						return mLeft->insert_recursive(val);
+						set_left(mLeft->insert_recursive(val, num_added));
 					else
 					{
-						mLeft = new node(val);
-						return 1;
+						mLeft = new node(val, this);
+						num_added = 1;
 					}
 				}
 				else if (val > mData)
 				{
 					if (mRight)
-						return mRight->insert_recursive(val);
+						set_right(mRight->insert_recursive(val, num_added));
 					else
 					{
-						mRight = new node(val);
-						return 1;
+						mRight = new node(val, this);
+						num_added = 1;
 					}
 				}
 				else
 				{
-					// This node already exists -- just return 0 since there's nothing else we need to do
-					return 0;
+					// This node already exists -- there's nothing else we need to do
+					return this;
 				}
+				return rebalance();
 			}
 
 
 			/// <summary>
-			///  Used to generate a copy of all data in this set in a certain order
+			/// Visits every node of the subtree rooted here three times -- before its left subtree, between
+			/// its subtrees and after its right subtree -- which is all a pre-, in- or post-order traversal
+			/// needs.  It is iterative: the parent pointers lead back up, and where we came from (our parent,
+			/// our left child or our right child) says which of the three visits is next.
 			/// </summary>
-			/// <param name="data">a reference parameter used to store all data</param>
-			/// <param name="tp">which type of traversal?</param>
-			void traversal_recursive(ssuds::ArrayList<T>& data, TraversalType tp)
-			{
-				if (tp == TraversalType::PRE_ORDER)
-					data.append(mData);
-				if (mLeft)
-					mLeft->traversal_recursive(data, tp);
-				if (tp == TraversalType::IN_ORDER)
-					data.append(mData);
-				if (mRight)
-					mRight->traversal_recursive(data, tp);
-				if (tp == TraversalType::POST_ORDER)
-					data.append(mData);
+			/// <param name="visit">called as visit(node, TraversalType of this visit, depth below us)</param>
+			template <class Visitor>
+			void walk(Visitor visit)
+			{
+				node* stop = mParent;
+				node* prev = mParent;
+				node* cur = this;
+				int depth = 0;
+				while (cur != stop)
+				{
+					node* next;
+					if (prev == cur->mParent)
+					{
+						visit(cur, TraversalType::PRE_ORDER, depth);
+						if (cur->mLeft)
+							next = cur->mLeft;
+						else
+						{
+							visit(cur, TraversalType::IN_ORDER, depth);
+							next = cur->mRight;
+						}
+					}
+					else if (prev == cur->mLeft)
+					{
+						visit(cur, TraversalType::IN_ORDER, depth);
+						next = cur->mRight;
+					}
+					else
+						next = nullptr;
+
+					if (next)
+						depth++;
+					else
+					{
+						visit(cur, TraversalType::POST_ORDER, depth);
+						next = cur->mParent;
+						depth--;
+					}
+					prev = cur;
+					cur = next;
+				}
 			}
 		};
 
@@ -278,12 +398,8 @@ namespace ssuds
 		{
 		protected:
 			/// <summary>
-			///  Used to keep track of which nodes we still have to explore
-			/// </summary>
-			ssuds::Stack<node*> mNodeStack;
-
-			/// <summary>
-			/// Keeps track of which node we are currently on (or null if we are done)
+			/// Keeps track of which node we are currently on (or null if we are done).  The nodes' parent
+			/// pointers are all we need to find the next one, so an iterator never allocates memory.
 			/// </summary>
 			node* mCurrentNode;
 
@@ -300,20 +416,10 @@ namespace ssuds
 			/// <summary>
 			///  Constructor
 			/// </summary>
-			/// <param name="root">the starting node (or null for end iterators)</param>
-			OrderedSetIterator(node* root)
+			/// <param name="start">the node to start on (or null for end iterators)</param>
+			OrderedSetIterator(node* start) : mCurrentNode(start)
 			{
-				mCurrentNode = root;
-				while (mCurrentNode)
-				{
-					mNodeStack.push(mCurrentNode);
-					mCurrentNode = mCurrentNode->mLeft;
-				}
-				if (!mNodeStack.empty())
-				{
-					mCurrentNode = mNodeStack.top();
-					mNodeStack.pop();
-				}
+				// empty, on purpose
 			}
 
 			/// <summary>
@@ -333,18 +439,7 @@ namespace ssuds
 			/// </summary>
 			void operator++()
 			{
-				mCurrentNode = mCurrentNode->mRight;
-				while (mCurrentNode)
-				{
-					mNodeStack.push(mCurrentNode);
-					mCurrentNode = mCurrentNode->mLeft;
-				}
-
-				if (!mNodeStack.empty())
-				{
-					mCurrentNode = mNodeStack.top();
-					mNodeStack.pop();
-				}
+				mCurrentNode = node::next_in_order(mCurrentNode);
 			}
 
 			/// <summary>
@@ -352,10 +447,20 @@ namespace ssuds
 			/// </summary>
 			/// <param name="other">the other iterator</param>
 			/// <returns>true if they are unequal</returns>
-			bool operator!=(const OrderedSetIterator& other)
+			bool operator!=(const OrderedSetIterator& other) const
 			{
 				return mCurrentNode != other.mCurrentNode;
 			}
+
+			/// <summary>
+			/// Returns true if two iterators are on the same node
+			/// </summary>
+			/// <param name="other">the other iterator</param>
+			/// <returns>true if they are equal</returns>
+			bool operator==(const OrderedSetIterator& other) const
+			{
+				return mCurrentNode == other.mCurrentNode;
+			}
 		};
 
 
@@ -385,8 +490,8 @@ namespace ssuds
 		/// <param name="other">the set we wish to copy</param>
 		OrderedSet(const OrderedSet& other) : mRoot(nullptr), mSize(0)
 		{
-			for (T val : other)
-				insert(val);
+			ssuds::ArrayList<T> data = other.traversal(TraversalType::IN_ORDER);
+			build_from_sorted(data);
 		}
 
 
@@ -443,20 +548,105 @@ namespace ssuds
 		/// <returns>A reference to us</returns>
 		OrderedSet& operator=(const OrderedSet& other)
 		{
-			clear();
-			for (T item : other)
-				insert(item);
+			ssuds::ArrayList<T> data = other.traversal(TraversalType::IN_ORDER);
+			build_from_sorted(data);
+			return *this;
+		}
+
+
+		/// <summary>
+		/// Adds every value of the other set to this one (this = this UNION other)
+		/// </summary>
+		/// <param name="other">the other set</param>
+		/// <returns>A reference to us</returns>
+		OrderedSet& operator|=(const OrderedSet& other)
+		{
+			ssuds::ArrayList<T> data = merge(*this, other, true, true, true);
+			build_from_sorted(data);
 			return *this;
 		}
 
 
+		/// <summary>
+		/// Removes every value that isn't also in the other set (this = this INTERSECT other)
+		/// </summary>
+		/// <param name="other">the other set</param>
+		/// <returns>A reference to us</returns>
+		OrderedSet& operator&=(const OrderedSet& other)
+		{
+			ssuds::ArrayList<T> data = merge(*this, other, false, true, false);
+			build_from_sorted(data);
+			return *this;
+		}
+
+
+		/// <summary>
+		/// Removes every value that is in the other set (this = this - other)
+		/// </summary>
+		/// <param name="other">the other set</param>
+		/// <returns>A reference to us</returns>
+		OrderedSet& operator-=(const OrderedSet& other)
+		{
+			ssuds::ArrayList<T> data = merge(*this, other, true, false, false);
+			build_from_sorted(data);
+			return *this;
+		}
+
+
+		/// <summary>
+		/// Returns the UNION of two sets.  Like the other set operators, this merges the two in-order
+		/// sequences in lockstep and builds the result tree straight from the merged (sorted) values, so it
+		/// is O(|A| + |B|) rather than an O(log n) insert or lookup per value.
+		/// </summary>
+		/// <param name="A">set1</param>
+		/// <param name="B">set2</param>
+		/// <returns>The resulting union</returns>
+		friend OrderedSet operator|(const OrderedSet& A, const OrderedSet& B)
+		{
+			OrderedSet result;
+			ssuds::ArrayList<T> data = merge(A, B, true, true, true);
+			result.build_from_sorted(data);
+			return result;
+		}
+
+
+		/// <summary>
+		/// Returns the INTERSECTION of two sets
+		/// </summary>
+		/// <param name="A">set1</param>
+		/// <param name="B">set2</param>
+		/// <returns>The resulting intersection</returns>
+		friend OrderedSet operator&(const OrderedSet& A, const OrderedSet& B)
+		{
+			OrderedSet result;
+			ssuds::ArrayList<T> data = merge(A, B, false, true, false);
+			result.build_from_sorted(data);
+			return result;
+		}
+
+
+		/// <summary>
+		/// Returns the RELATIVE DIFFERENCE of two sets
+		/// </summary>
+		/// <param name="A">set1</param>
+		/// <param name="B">set2</param>
+		/// <returns>The resulting difference</returns>
+		friend OrderedSet operator-(const OrderedSet& A, const OrderedSet& B)
+		{
+			OrderedSet result;
+			ssuds::ArrayList<T> data = merge(A, B, true, false, false);
+			result.build_from_sorted(data);
+			return result;
+		}
+
+
 		/// <summary>
 		/// Create an iterator that is "pointing" to the first (lowest) element
 		/// </summary>
 		/// <returns>A valid iterator if the set is non-empty, or the end iterator if not</returns>
 		OrderedSetIterator begin() const
 		{
-			return OrderedSetIterator(mRoot);
+			return OrderedSetIterator(node::leftmost(mRoot));
 		}
 
 
@@ -466,7 +656,7 @@ namespace ssuds
 		/// </summary>
 		void clear()
 		{
-			delete mRoot;
+			node::destroy_subtree(mRoot);
 			mRoot = nullptr;
 			mSize = 0;
 		}
@@ -508,13 +698,9 @@ namespace ssuds
 
 			if (mRoot)
 			{
-				node* new_root = mRoot->erase_recursive(val, result);
-				if (new_root != mRoot)
-				{
-					mRoot->clear_children();
-					delete mRoot;
-					mRoot = new_root;
-				}
+				mRoot = mRoot->erase_recursive(val, result);
+				if (mRoot)
+					mRoot->mParent = nullptr;
 			}
 			if (result)
 				mSize--;
@@ -528,10 +714,7 @@ namespace ssuds
 		/// <returns></returns>
 		unsigned int get_height() const
 		{
-			if (mRoot)
-				return mRoot->get_height_recursive();
-			else
-				return 0;
+			return node::height(mRoot);
 		}
 
 		/// <summary>
@@ -543,7 +726,10 @@ namespace ssuds
 		{
 			int num_added = 0;
 			if (mRoot)
-				num_added = mRoot->insert_recursive(val);
+			{
+				mRoot = mRoot->insert_recursive(val, num_added);
+				mRoot->mParent = nullptr;
+			}
 			else
 			{
 				mRoot = new node(val);
@@ -556,18 +742,82 @@ namespace ssuds
 
 
 		/// <summary>
-		///  A very costly operation which makes this an optimal tree (lowest depth)
+		///  A costly operation which makes this an optimal tree (lowest depth).  The tree keeps itself
+		///  balanced, so this is rarely needed; it can shave a level or so off the height.
 		/// </summary>
 		void rebalance()
 		{
 			ssuds::ArrayList<T> data = traversal(TraversalType::IN_ORDER);
+			build_from_sorted(data);
+		}
+
+	protected:
+		/// <summary>
+		/// Replaces our contents with an optimal tree holding the given values, in O(n)
+		/// </summary>
+		/// <param name="data">the new values, sorted and without duplicates</param>
+		void build_from_sorted(ssuds::ArrayList<T>& data)
+		{
 			clear();
 			if (data.size() > 0)
 				mRoot = rebalance_helper(data, 0, data.size() - 1);
 			mSize = data.size();
 		}
 
-	protected:
+
+		/// <summary>
+		/// Walks the values of two sets in order, side by side (like the merge step of merge sort), and
+		/// collects the ones the caller asks for
+		/// </summary>
+		/// <param name="A">set1</param>
+		/// <param name="B">set2</param>
+		/// <param name="keep_only_a">keep the values that are only in A?</param>
+		/// <param name="keep_both">keep the values that are in both sets?</param>
+		/// <param name="keep_only_b">keep the values that are only in B?</param>
+		/// <returns>the kept values, in order</returns>
+		static ssuds::ArrayList<T> merge(const OrderedSet& A, const OrderedSet& B, bool keep_only_a, bool keep_both, bool keep_only_b)
+		{
+			ssuds::ArrayList<T> result;
+			unsigned int capacity = 0;
+			if (keep_only_a)
+				capacity += A.mSize;
+			if (keep_only_b)
+				capacity += B.mSize;
+			if (keep_both && capacity == 0)
+				capacity = A.mSize < B.mSize ? A.mSize : B.mSize;
+			result.reserve(capacity);
+
+			node* a = node::leftmost(A.mRoot);
+			node* b = node::leftmost(B.mRoot);
+			while (a && b)
+			{
+				if (a->mData < b->mData)
+				{
+					if (keep_only_a)
+						result.append(a->mData);
+					a = node::next_in_order(a);
+				}
+				else if (b->mData < a->mData)
+				{
+					if (keep_only_b)
+						result.append(b->mData);
+					b = node::next_in_order(b);
+				}
+				else
+				{
+					if (keep_both)
+						result.append(a->mData);
+					a = node::next_in_order(a);
+					b = node::next_in_order(b);
+				}
+			}
+			for (; a && keep_only_a; a = node::next_in_order(a))
+				result.append(a->mData);
+			for (; b && keep_only_b; b = node::next_in_order(b))
+				result.append(b->mData);
+			return result;
+		}
+
 		/// <summary>
 		///  An internal method, structured something like binary search that is used to rebalance
 		/// this tree
@@ -582,8 +832,9 @@ namespace ssuds
 			{
 				int mid = (left + right) / 2;
 				node* cur_root = new node(data[mid]);
-				cur_root->mLeft = rebalance_helper(data, left, mid - 1);
-				cur_root->mRight = rebalance_helper(data, mid + 1, right);
+				cur_root->set_left(rebalance_helper(data, left, mid - 1));
+				cur_root->set_right(rebalance_helper(data, mid + 1, right));
+				cur_root->update_stats();
 				return cur_root;
 			}
 			else
@@ -596,11 +847,149 @@ namespace ssuds
 		/// Returns the number of elements in a set
 		/// </summary>
 		/// <returns></returns>
-		unsigned int size()
+		unsigned int size() const
 		{
 			return mSize;
 		}
 
+
+		/// <summary>
+		/// Counts the values that come before val (val itself doesn't have to be in the set).  For a value
+		/// in the set, this is its index in an in-order traversal.  O(log n)
+		/// </summary>
+		/// <param name="val">the value to look for</param>
+		/// <returns>the number of values less than val</returns>
+		unsigned int rank(const T& val) const
+		{
+			return count_before(val, false);
+		}
+
+
+		/// <summary>
+		/// Gets the value with the given rank (select(0) is the lowest value, select(size() - 1) the
+		/// highest).  O(log n)
+		/// </summary>
+		/// <param name="index">the rank of the value we want</param>
+		/// <returns>that value</returns>
+		const T& select(unsigned int index) const
+		{
+			if (index >= mSize)
+				throw std::out_of_range("Invalid index: " + std::to_string(index));
+			node* cur = mRoot;
+			while (true)
+			{
+				unsigned int left_count = node::count(cur->mLeft);
+				if (index < left_count)
+					cur = cur->mLeft;
+				else if (index > left_count)
+				{
+					index -= left_count + 1;
+					cur = cur->mRight;
+				}
+				else
+					return cur->mData;
+			}
+		}
+
+
+		/// <summary>
+		/// Finds the lowest value that is not less than val
+		/// </summary>
+		/// <param name="val">the value to look for</param>
+		/// <returns>an iterator on that value (or the end iterator if there is none)</returns>
+		OrderedSetIterator lower_bound(const T& val) const
+		{
+			return OrderedSetIterator(find_bound(val, false));
+		}
+
+
+		/// <summary>
+		/// Finds the lowest value that is greater than val
+		/// </summary>
+		/// <param name="val">the value to look for</param>
+		/// <returns>an iterator on that value (or the end iterator if there is none)</returns>
+		OrderedSetIterator upper_bound(const T& val) const
+		{
+			return OrderedSetIterator(find_bound(val, true));
+		}
+
+
+		/// <summary>
+		/// Counts the values in the (inclusive) range lo...hi without visiting them.  O(log n)
+		/// </summary>
+		/// <param name="lo">the lowest value to count</param>
+		/// <param name="hi">the highest value to count</param>
+		/// <returns>the number of values v with lo &lt;= v &lt;= hi</returns>
+		unsigned int count_range(const T& lo, const T& hi) const
+		{
+			if (hi < lo)
+				return 0;
+			return count_before(hi, true) - count_before(lo, false);
+		}
+
+
+		/// <summary>
+		/// Calls func on each value in the (inclusive) range lo...hi, in order.  O(log n + the number of
+		/// values in the range)
+		/// </summary>
+		/// <param name="lo">the lowest value to visit</param>
+		/// <param name="hi">the highest value to visit</param>
+		/// <param name="func">called as func(value) for each value</param>
+		template <class Func>
+		void for_each_in_range(const T& lo, const T& hi, Func func) const
+		{
+			for (node* cur = find_bound(lo, false); cur && !(hi < cur->mData); cur = node::next_in_order(cur))
+				func((const T&)cur->mData);
+		}
+
+	protected:
+		/// <summary>
+		/// Counts the values less than (or, if or_equal is true, less than or equal to) val by walking
+		/// down from the root and adding up the left subtrees we pass by
+		/// </summary>
+		unsigned int count_before(const T& val, bool or_equal) const
+		{
+			unsigned int result = 0;
+			node* cur = mRoot;
+			while (cur)
+			{
+				bool go_right = or_equal ? !(val < cur->mData) : cur->mData < val;
+				if (go_right)
+				{
+					result += node::count(cur->mLeft) + 1;
+					cur = cur->mRight;
+				}
+				else
+					cur = cur->mLeft;
+			}
+			return result;
+		}
+
+
+		/// <summary>
+		/// Finds the lowest node whose value is not less than (or, if strict is true, greater than) val
+		/// </summary>
+		/// <returns>that node (or nullptr if there is none)</returns>
+		node* find_bound(const T& val, bool strict) const
+		{
+			node* result = nullptr;
+			node* cur = mRoot;
+			while (cur)
+			{
+				bool go_right = strict ? !(val < cur->mData) : cur->mData < val;
+				if (go_right)
+					cur = cur->mRight;
+				else
+				{
+					result = cur;
+					cur = cur->mLeft;
+				}
+			}
+			return result;
+		}
+
+	public:
+
 		/// <summary>
 		/// Used to create an in-order, pre-order, or post-order copy of all the data in this tree
 		/// </summary>
@@ -609,8 +998,15 @@ namespace ssuds
 		ssuds::ArrayList<T> traversal(TraversalType tp) const
 		{
 			ssuds::ArrayList<T> results;
+			results.reserve(mSize);
 			if (mRoot)
-				mRoot->traversal_recursive(results, tp);
+			{
+				mRoot->walk([&](node* n, TraversalType when, int)
+				{
+					if (when == tp)
+						results.append(n->mData);
+				});
+			}
 			return results;
 		}
 
@@ -626,66 +1022,19 @@ namespace ssuds
 		{
 			std::stringstream ss;
 			if (mRoot)
-				mRoot->generate_string_recursive(ss, 0, "");
+			{
+				mRoot->walk([&](node* n, TraversalType when, int depth)
+				{
+					if (when != TraversalType::PRE_ORDER)
+						return;
+					for (int i = 0; i < depth; i++)
+						ss << "   ";
+					if (n != mRoot)
+						ss << (n == n->mParent->mLeft ? "L: " : "R: ");
+					ss << n->mData << std::endl;
+				});
+			}
 			return ss.str();
 		}
 	};
-
-
-
-	/// <summary>
-	/// Returns the UNION of two sets
-	/// </summary>
-	/// <typeparam name="T">the type of the set</typeparam>
-	/// <param name="A">set1</param>
-	/// <param name="B">set2</param>
-	/// <returns>The resulting union</returns>
-	template <class T>
-	OrderedSet<T> operator|(const OrderedSet<T>& A, const OrderedSet<T>& B)
-	{
-		OrderedSet<T> result = A;
-		for (T item : B)
-			result.insert(item);
-		return result;
-	}
-
-
-	/// <summary>
-	/// Returns the INTERSECTION of two sets
-	/// </summary>
-	/// <typeparam name="T">the type of the set</typeparam>
-	/// <param name="A">set1</param>
-	/// <param name="B">set2</param>
-	/// <returns>The resulting intersection</returns>
-	template <class T>
-	OrderedSet<T> operator&(const OrderedSet<T>& A, const OrderedSet<T>& B)
-	{
-		OrderedSet<T> result;
-		for (T item : B)
-		{
-			if (A.contains(item))
-				result.insert(item);
-		}
-		return result;
-	}
-
-
-	/// <summary>
-	/// Returns the RELATIVE DIFFERENCE of two sets
-	/// </summary>
-	/// <typeparam name="T">the type of the set</typeparam>
-	/// <param name="A">set1</param>
-	/// <param name="B">set2</param>
-	/// <returns>The resulting difference</returns>
-	template <class T>
-	OrderedSet<T> operator-(const OrderedSet<T>& A, const OrderedSet<T>& B)
-	{
-		OrderedSet<T> result;
-		for (T item : A)
-		{
-			if (!B.contains(item))
-				result.insert(item);
-		}
-		return result;
-	}
 }
@@ -0,0 +1,163 @@
+#pragma once
+#include <array_list.h>
+#include <utility>
+#include <stdexcept>
+
+namespace ssuds
+{
+	/// <summary>
+	/// A min-priority queue: the element with the SMALLEST priority is always at the top.  Internally this
+	/// is a d-ary heap stored in an ArrayList (so no per-element allocations).  A larger arity makes the
+	/// heap shallower (cheaper pushes) at the cost of more comparisons per pop.
+	///
+	/// There is no decrease-key operation.  Algorithms like Dijkstra should use "lazy deletion": push
+	/// the element again with its new (smaller) priority and skip the stale copy when it is popped later.
+	/// </summary>
+	/// <typeparam name="T">The type of all elements in the queue</typeparam>
+	/// <typeparam name="P">The type of the priorities (must support operator&lt;)</typeparam>
+	/// <typeparam name="D">The arity (number of children per heap node) -- must be at least 2</typeparam>
+	template <class T, class P = float, unsigned int D = 2>
+	class PriorityQueue
+	{
+		static_assert(D >= 2, "A PriorityQueue must have an arity of at least 2");
+
+	protected:
+		/// <summary>
+		/// The heap (priority, value pairs).  The children of index i are at D*i+1 ... D*i+D
+		/// </summary>
+		ArrayList<std::pair<P, T>> mHeap;
+
+	public:
+		/// <summary>
+		/// Removes all elements (the internal array keeps its capacity, so a cleared queue can be re-used cheaply)
+		/// </summary>
+		void clear()
+		{
+			while (mHeap.size() > 0)
+				mHeap.remove(mHeap.size() - 1, false);
+		}
+
+
+		/// <summary>
+		/// Returns true if the queue is empty
+		/// </summary>
+		/// <returns>a boolean (is the queue empty?)</returns>
+		bool empty() const
+		{
+			return mHeap.size() == 0;
+		}
+
+
+		/// <summary>
+		/// Removes and returns the element with the smallest priority.  This method will raise an
+		/// exception if the queue is empty.
+		/// </summary>
+		/// <returns>The (old) top element</returns>
+		T pop()
+		{
+			if (mHeap.size() == 0)
+				throw std::out_of_range("You cannot pop from an empty priority queue");
+			T result = mHeap[0].second;
+			std::pair<P, T> last = mHeap.remove(mHeap.size() - 1, false);
+			if (mHeap.size() > 0)
+				sift_down(last);
+			return result;
+		}
+
+
+		/// <summary>
+		/// Adds a new element to the queue
+		/// </summary>
+		/// <param name="val">the new element</param>
+		/// <param name="priority">its priority (smaller values come out first)</param>
+		void push(const T& val, const P& priority)
+		{
+			mHeap.append(std::pair<P, T>(priority, val));
+			sift_up(mHeap.size() - 1);
+		}
+
+
+		/// <summary>
+		/// Returns the number of elements in the queue
+		/// </summary>
+		/// <returns>number of elements</returns>
+		unsigned int size() const
+		{
+			return mHeap.size();
+		}
+
+
+		/// <summary>
+		/// Returns a reference to the element with the smallest priority (without removing it)
+		/// </summary>
+		/// <returns>the top element</returns>
+		const T& top() const
+		{
+			if (mHeap.size() == 0)
+				throw std::out_of_range("You cannot get the top of an empty priority queue");
+			return mHeap[0].second;
+		}
+
+
+		/// <summary>
+		/// Returns the priority of the top element
+		/// </summary>
+		/// <returns>the smallest priority in the queue</returns>
+		const P& top_priority() const
+		{
+			if (mHeap.size() == 0)
+				throw std::out_of_range("You cannot get the top of an empty priority queue");
+			return mHeap[0].first;
+		}
+
+	protected:
+		/// <summary>
+		/// Moves the element at index up until its parent is not larger than it.  Rather than swapping at
+		/// every level, parents are shifted down into the "hole" and the element is written once at the end.
+		/// </summary>
+		/// <param name="index">the index of the (possibly) out-of-place element</param>
+		void sift_up(unsigned int index)
+		{
+			std::pair<P, T> item = mHeap[index];
+			while (index > 0)
+			{
+				unsigned int parent = (index - 1) / D;
+				if (!(item.first < mHeap[parent].first))
+					break;
+				mHeap[index] = mHeap[parent];
+				index = parent;
+			}
+			mHeap[index] = item;
+		}
+
+
+		/// <summary>
+		/// Places item, starting at the root, moving the smallest child up into the hole until item
+		/// is no larger than all of its children
+		/// </summary>
+		/// <param name="item">the element to place (generally the old last element)</param>
+		void sift_down(const std::pair<P, T>& item)
+		{
+			unsigned int size = mHeap.size();
+			unsigned int index = 0;
+			while (true)
+			{
+				unsigned int first_child = D * index + 1;
+				if (first_child >= size)
+					break;
+				unsigned int last_child = first_child + D < size ? first_child + D : size;
+				unsigned int best = first_child;
+				for (unsigned int c = first_child + 1; c < last_child; c++)
+				{
+					if (mHeap[c].first < mHeap[best].first)
+						best = c;
+				}
+				if (!(mHeap[best].first < item.first))
+					break;
+				mHeap[index] = mHeap[best];
+				index = best;
+			}
+			mHeap[index] = item;
+		}
+	};
+}
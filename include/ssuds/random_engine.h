@@ -0,0 +1,155 @@
+#pragma once
+#include <cstdint>
+#include <random>
+
+namespace ssuds
+{
+	/// <summary>
+	/// The SplitMix64 generator step: returns a well-mixed 64-bit value and advances state.  Used to turn one
+	/// seed into a full Xoshiro256 state.
+	/// </summary>
+	/// <param name="state">the generator state (advanced by this call)</param>
+	/// <returns>the next value</returns>
+	inline std::uint64_t _splitmix64(std::uint64_t& state)
+	{
+		std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+
+	/// <summary>
+	/// The xoshiro256** pseudo-random generator: 256 bits of state, a period of 2^256 - 1, and only a few
+	/// shifts / rotates / multiplies per 64-bit value, which makes it several times faster than std::mt19937.
+	/// It meets the C++ UniformRandomBitGenerator requirements, so it also works with the std distributions.
+	/// It is NOT suitable for cryptography.
+	/// </summary>
+	class Xoshiro256
+	{
+	public:
+		typedef std::uint64_t result_type;
+
+	protected:
+		/// <summary>
+		/// The generator state (never all zero)
+		/// </summary>
+		std::uint64_t mState[4];
+
+	public:
+		/// <summary>
+		/// Constructor.  The same seed always gives the same sequence.
+		/// </summary>
+		/// <param name="seed">any value</param>
+		explicit Xoshiro256(std::uint64_t seed = 0)
+		{
+			this->seed(seed);
+		}
+
+
+		/// <summary>
+		/// Constructor for one of many independent streams from the same seed (e.g. one per thread / block).
+		/// </summary>
+		/// <param name="seed">any value</param>
+		/// <param name="stream">the stream number</param>
+		Xoshiro256(std::uint64_t seed, std::uint64_t stream)
+		{
+			std::uint64_t mixer = stream;
+			this->seed(seed ^ _splitmix64(mixer));
+		}
+
+
+		/// <summary>
+		/// Restarts the sequence from a new seed
+		/// </summary>
+		/// <param name="seed">any value</param>
+		void seed(std::uint64_t seed)
+		{
+			// SplitMix64 never produces four zeros in a row, so the state is always valid
+			for (int i = 0; i < 4; i++)
+				mState[i] = _splitmix64(seed);
+		}
+
+
+		/// The smallest value operator() returns
+		static constexpr result_type min()
+		{
+			return 0;
+		}
+
+
+		/// The biggest value operator() returns
+		static constexpr result_type max()
+		{
+			return ~(result_type)0;
+		}
+
+
+		/// <summary>
+		/// Generates the next value
+		/// </summary>
+		/// <returns>64 random bits</returns>
+		result_type operator()()
+		{
+			// Reference: https://prng.di.unimi.it/xoshiro256starstar.c
+			std::uint64_t result = rotate_left(mState[1] * 5, 7) * 9;
+			std::uint64_t t = mState[1] << 17;
+			mState[2] ^= mState[0];
+			mState[3] ^= mState[1];
+			mState[1] ^= mState[2];
+			mState[0] ^= mState[3];
+			mState[2] ^= t;
+			mState[3] = rotate_left(mState[3], 45);
+			return result;
+		}
+
+	protected:
+		static std::uint64_t rotate_left(std::uint64_t x, int amount)
+		{
+			return (x << amount) | (x >> (64 - amount));
+		}
+	};
+
+
+	/// <summary>
+	/// Gets 32 random bits from engine.  Engines whose values cover exactly 32 or 64 bits (std::mt19937,
+	/// std::mt19937_64, Xoshiro256) are used directly; anything else goes through a std distribution.
+	/// </summary>
+	template <class Engine>
+	std::uint32_t _random_bits32(Engine& engine)
+	{
+		if (Engine::min() == 0 && (unsigned long long)Engine::max() == 0xFFFFFFFFFFFFFFFFull)
+			return (std::uint32_t)((unsigned long long)engine() >> 32);
+		if (Engine::min() == 0 && (unsigned long long)Engine::max() == 0xFFFFFFFFull)
+			return (std::uint32_t)engine();
+		return std::uniform_int_distribution<std::uint32_t>(0, 0xFFFFFFFFu)(engine);
+	}
+
+
+	/// <summary>
+	/// Generates a uniformly-distributed random number in 0...bound-1 with Lemire's multiply-shift method:
+	/// the high half of random * bound is the answer, and the low half tells us (rarely) that we hit one of
+	/// the few values that would bias the result and must draw again.  This avoids the division that a
+	/// modulo-based (or std::uniform_int_distribution) approach needs on every call.
+	/// </summary>
+	/// <param name="engine">the random generator</param>
+	/// <param name="bound">the number of possible results (must be at least 1)</param>
+	/// <returns>the random number</returns>
+	template <class Engine>
+	std::uint32_t uniform_below(Engine& engine, std::uint32_t bound)
+	{
+		// Reference: https://arxiv.org/abs/1805.10941 (Lemire, "Fast Random Integer Generation in an Interval")
+		std::uint64_t product = (std::uint64_t)_random_bits32(engine) * bound;
+		std::uint32_t low = (std::uint32_t)product;
+		if (low < bound)
+		{
+			std::uint32_t threshold = (0u - bound) % bound;
+			while (low < threshold)
+			{
+				product = (std::uint64_t)_random_bits32(engine) * bound;
+				low = (std::uint32_t)product;
+			}
+		}
+		return (std::uint32_t)(product >> 32);
+	}
+}
@@ -0,0 +1,292 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+namespace ssuds
+{
+	/// <summary>
+	/// A fixed-size pool of worker threads for data-parallel loops.  A call to parallel_for splits the
+	/// task numbers 0...num_tasks-1 into one contiguous block per worker.  Each worker takes tasks from the back
+	/// of its own block and, once that is empty, steals from the front of another worker's block, so uneven
+	/// tasks still keep every thread busy.  The calling thread acts as worker 0, so a pool of N threads starts
+	/// N-1 extra threads.
+	/// </summary>
+	class ThreadPool
+	{
+	protected:
+		/// <summary>
+		/// One worker's share of the current job: the task numbers [mHead, mTail).  The owner pops from the
+		/// tail and thieves steal from the head.
+		/// </summary>
+		class TaskDeque
+		{
+		protected:
+			std::mutex mMutex;
+			unsigned int mHead;
+			unsigned int mTail;
+
+		public:
+			/// Constructor (an empty deque)
+			TaskDeque() : mHead(0), mTail(0)
+			{
+				// empty, on purpose
+			}
+
+			/// Replaces the contents with the task numbers [first, last)
+			void reset(unsigned int first, unsigned int last)
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mHead = first;
+				mTail = last;
+			}
+
+			/// Takes the task at the back (used by the owner).  Returns false if empty
+			bool pop(unsigned int& task)
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				if (mHead == mTail)
+					return false;
+				task = --mTail;
+				return true;
+			}
+
+			/// Takes the task at the front (used by other workers).  Returns false if empty
+			bool steal(unsigned int& task)
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				if (mHead == mTail)
+					return false;
+				task = mHead++;
+				return true;
+			}
+		};
+
+		/// <summary>
+		/// The number of workers (including the calling thread)
+		/// </summary>
+		unsigned int mNumThreads;
+
+		/// <summary>
+		/// The extra threads (mNumThreads - 1 of them)
+		/// </summary>
+		std::thread* mThreads;
+
+		/// <summary>
+		/// One deque per worker
+		/// </summary>
+		TaskDeque* mDeques;
+
+		/// <summary>
+		/// Protects all of the job-control attributes below
+		/// </summary>
+		std::mutex mMutex;
+
+		/// <summary>
+		/// Signalled when a new job starts (or the pool is shutting down)
+		/// </summary>
+		std::condition_variable mStartCondition;
+
+		/// <summary>
+		/// Signalled when the last extra thread finishes the current job
+		/// </summary>
+		std::condition_variable mDoneCondition;
+
+		/// <summary>
+		/// Increases by one for every job, so the workers can tell a new job from a spurious wake-up
+		/// </summary>
+		unsigned long long mGeneration;
+
+		/// <summary>
+		/// How many extra threads are still working on the current job
+		/// </summary>
+		unsigned int mActive;
+
+		/// <summary>
+		/// Set by the destructor to make the threads exit
+		/// </summary>
+		bool mStopping;
+
+		/// <summary>
+		/// The function of the current job
+		/// </summary>
+		const std::function<void(unsigned int, unsigned int)>* mJob;
+
+		/// <summary>
+		/// The first exception raised by a task in the current job (re-thrown by parallel_for)
+		/// </summary>
+		std::exception_ptr mError;
+
+	public:
+		/// <summary>
+		/// Constructor
+		/// </summary>
+		/// <param name="num_threads">the number of workers (0 = one per hardware thread)</param>
+		ThreadPool(unsigned int num_threads = 0) : mThreads(nullptr), mGeneration(0), mActive(0), mStopping(false), mJob(nullptr)
+		{
+			if (num_threads == 0)
+				num_threads = std::thread::hardware_concurrency();
+			if (num_threads == 0)
+				num_threads = 1;
+			mNumThreads = num_threads;
+			mDeques = new TaskDeque[mNumThreads];
+			if (mNumThreads > 1)
+			{
+				mThreads = new std::thread[mNumThreads - 1];
+				for (unsigned int i = 1; i < mNumThreads; i++)
+					mThreads[i - 1] = std::thread(&ThreadPool::worker_loop, this, i);
+			}
+		}
+
+		/// A pool can't be copied
+		ThreadPool(const ThreadPool&) = delete;
+
+		/// A pool can't be copied
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/// Destructor (waits for the threads to exit)
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mStopping = true;
+			}
+			mStartCondition.notify_all();
+			for (unsigned int i = 1; i < mNumThreads; i++)
+				mThreads[i - 1].join();
+			delete[] mThreads;
+			delete[] mDeques;
+		}
+
+
+		/// <summary>
+		/// Returns the number of workers (including the calling thread)
+		/// </summary>
+		/// <returns>number of workers</returns>
+		unsigned int num_threads() const
+		{
+			return mNumThreads;
+		}
+
+
+		/// <summary>
+		/// Calls func(task, worker) for every task in 0...num_tasks-1 and returns once they have all finished.
+		/// worker (0...num_threads()-1) identifies the thread running the task, which is handy for per-thread
+		/// scratch buffers.  If a task throws, the remaining tasks still run and the first exception is re-thrown
+		/// here.  parallel_for must not be called from inside a task.
+		/// </summary>
+		/// <param name="num_tasks">the number of tasks</param>
+		/// <param name="func">the task function</param>
+		void parallel_for(unsigned int num_tasks, const std::function<void(unsigned int, unsigned int)>& func)
+		{
+			if (num_tasks == 0)
+				return;
+			if (mNumThreads == 1 || num_tasks == 1)
+			{
+				std::exception_ptr error;
+				for (unsigned int t = 0; t < num_tasks; t++)
+				{
+					try
+					{
+						func(t, 0);
+					}
+					catch (...)
+					{
+						if (!error)
+							error = std::current_exception();
+					}
+				}
+				if (error)
+					std::rethrow_exception(error);
+				return;
+			}
+
+			for (unsigned int w = 0; w < mNumThreads; w++)
+			{
+				unsigned int first = (unsigned int)((unsigned long long)num_tasks * w / mNumThreads);
+				unsigned int last = (unsigned int)((unsigned long long)num_tasks * (w + 1) / mNumThreads);
+				mDeques[w].reset(first, last);
+			}
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mJob = &func;
+				mError = nullptr;
+				mActive = mNumThreads - 1;
+				mGeneration++;
+			}
+			mStartCondition.notify_all();
+
+			run_tasks(0, func);
+
+			std::unique_lock<std::mutex> lock(mMutex);
+			mDoneCondition.wait(lock, [this]() { return mActive == 0; });
+			mJob = nullptr;
+			if (mError)
+			{
+				std::exception_ptr error = mError;
+				mError = nullptr;
+				std::rethrow_exception(error);
+			}
+		}
+
+	protected:
+		/// <summary>
+		/// The body of each extra thread: wait for a job, work on it, repeat
+		/// </summary>
+		/// <param name="worker">this thread's worker number</param>
+		void worker_loop(unsigned int worker)
+		{
+			unsigned long long seen_generation = 0;
+			while (true)
+			{
+				const std::function<void(unsigned int, unsigned int)>* job;
+				{
+					std::unique_lock<std::mutex> lock(mMutex);
+					mStartCondition.wait(lock, [&]() { return mStopping || mGeneration != seen_generation; });
+					if (mStopping)
+						return;
+					seen_generation = mGeneration;
+					job = mJob;
+				}
+
+				run_tasks(worker, *job);
+
+				std::lock_guard<std::mutex> lock(mMutex);
+				if (--mActive == 0)
+					mDoneCondition.notify_one();
+			}
+		}
+
+
+		/// <summary>
+		/// Runs tasks from our own deque, then steals from the others until every deque is empty
+		/// </summary>
+		/// <param name="worker">our worker number</param>
+		/// <param name="func">the task function</param>
+		void run_tasks(unsigned int worker, const std::function<void(unsigned int, unsigned int)>& func)
+		{
+			unsigned int task;
+			while (true)
+			{
+				bool found = mDeques[worker].pop(task);
+				for (unsigned int i = 1; !found && i < mNumThreads; i++)
+					found = mDeques[(worker + i) % mNumThreads].steal(task);
+				if (!found)
+					return;
+
+				try
+				{
+					func(task, worker);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(mMutex);
+					if (!mError)
+						mError = std::current_exception();
+				}
+			}
+		}
+	};
+}
@@ -1,14 +1,33 @@
 #pragma once
 #include <functional>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <cstring>
+#include <cstdint>
 #include <array_list.h>
 
-#define INITIAL_MAP_CAPACITY 5
+// Define SSUDS_NO_SIMD to use the portable (one byte at a time) control-byte probing even where SSE2 is available
+#if !defined(SSUDS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SSUDS_MAP_SSE2 1
+#include <emmintrin.h>
+#else
+#define SSUDS_MAP_SSE2 0
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define INITIAL_MAP_CAPACITY 8
 #define MAX_LOAD_FACTOR 0.7f
 
 namespace ssuds
 {
 	// An unordered map is a hash-table-based container for holdling keys and associated
-	// values.  It internally uses an array to hold nodes (similar to std::pair)
+	// values.  It internally uses an open-addressing array that holds the std::pairs inline,
+	// plus a parallel array of one-byte "control" values: each full slot's byte holds 7 bits of its
+	// key's hash, so a lookup can compare 16 slots at once (with SSE2) and only touches the keys
+	// whose hash fragment matches.  The capacity is always a power of two.
 	template <class K, class V>
 	class UnorderedMap
 	{
@@ -59,12 +78,10 @@ namespace ssuds
 				return mIndex != mi.mIndex || (mMapPtr != mi.mMapPtr && mIndex != -1);
 			}
 
-			/// Returns the current *node*'s values, but as a std::pair (so we don't have
-			/// to give the user access to our node class).  If we had made the map's
-			/// internal mData as an array of pair pointers, this translation wouldn't be necessary
+			/// Returns the current key-value pair (a reference to the one stored in the table)
 			std::pair<K, V>& operator*() const
 			{
-				return *mMapPtr->mData[mIndex];
+				return mMapPtr->mData[mIndex];
 			}
 
 			/// Advance the iteration
@@ -92,7 +109,7 @@ namespace ssuds
 			{
 				while (start < (long long)mMapPtr->mCapacity)
 				{
-					if (mMapPtr->mData[start] != NULL)
+					if (is_full(mMapPtr->mControl[start]))
 						return start;
 					start++;
 				}
@@ -103,9 +120,16 @@ namespace ssuds
 
 
 	protected:
-		/// An array of pair pointers.  In a default constructor this is initialized to the size INITIAL_MAP_CAPACITY, and
-		/// it "grows" when the load factor (mSize / mCapacity) reaches or exceeds MAX_LOAD_FACTOR
-		std::pair<K, V>** mData;
+		/// The key-value pairs, stored inline (one slot per pair) so adding an element doesn't need its own
+		/// allocation and a probe doesn't need to follow a pointer.  This is raw memory: only the full slots
+		/// (see mControl) hold a constructed pair.  In a default constructor this is initialized
+		/// to the size INITIAL_MAP_CAPACITY, and it "grows" when the load factor (mSize / mCapacity) would exceed MAX_LOAD_FACTOR
+		std::pair<K, V>* mData;
+
+		/// One control byte per slot of mData: msEmptySlot, or (for a full slot) the 7-bit hash fragment of its key.
+		/// There are msGroupWidth - 1 extra bytes at the end that mirror the first ones, so a group of msGroupWidth
+		/// bytes can be loaded starting at any slot without wrapping around
+		unsigned char* mControl;
 
 		/// The generator we use to create hash codes for our keys
 		std::hash<K> mHashGenerator;
@@ -116,30 +140,24 @@ namespace ssuds
 		/// The number of elements in mData
 		size_t mCapacity;
 
+		/// The control byte of a slot that doesn't hold a pair (full slots never have the high bit set)
+		static const unsigned char msEmptySlot = 0x80;
+
+		/// The number of control bytes examined per probe step
+		static const unsigned int msGroupWidth = 16;
+
 	public:
 		/// Default constructor
-		UnorderedMap() : mSize(0), mCapacity(INITIAL_MAP_CAPACITY)
+		UnorderedMap() : mData(nullptr), mControl(nullptr), mSize(0), mCapacity(0)
 		{
-			mData = new std::pair<K,V>* [mCapacity];
-			memset(mData, 0, sizeof(std::pair<K,V>*) * mCapacity);
+			allocate(INITIAL_MAP_CAPACITY);
 		}
 
 
 		/// Copy-constructor
-		UnorderedMap(const UnorderedMap& m)
+		UnorderedMap(const UnorderedMap& m) : mData(nullptr), mControl(nullptr), mSize(0), mCapacity(0)
 		{
-			mData = new std::pair<K,V>* [m.mCapacity];
-			mCapacity = m.mCapacity;
-			mSize = m.mSize;
-			// We shouldn't need to re-hash these since our table capacity is the same size
-			// We do, however, need to make a copy of their nodes
-			for (int i = 0; i < mCapacity; i++)
-			{
-				if (m.mData[i])
-					mData[i] = new std::pair<K,V>(*m.mData[i]);
-				else
-					mData[i] = nullptr;
-			}
+			copy_from(m);
 		}
 
 
@@ -147,9 +165,11 @@ namespace ssuds
 		UnorderedMap(UnorderedMap&& m)
 		{
 			mData = m.mData;
+			mControl = m.mControl;
 			mSize = m.mSize;
 			mCapacity = m.mCapacity;
 			m.mData = nullptr;
+			m.mControl = nullptr;
 			m.mSize = 0;
 			m.mCapacity = 0;
 		}
@@ -157,38 +177,16 @@ namespace ssuds
 
 		~UnorderedMap()
 		{
-			// Very important -- deleting our array would introduce a big memory leak.  We
-			//  need to delete the elements of our array first
-			for (int i = 0; i < mCapacity; i++)
-			{
-				// Note: many of these will be nullptr, but the delete properly handles that case
-				delete mData[i];
-			}
-
-			// Delete the array itself
-			delete[] mData;
+			release();
 		}
 
 		/// =operator
 		UnorderedMap& operator=(const UnorderedMap& other)
 		{
-			// Delete the non-null nodes in our table
-			for (int i = 0; i < mCapacity; i++)
-				delete mData[i];
-
-			// Delete the array itself
-			delete[] mData;
-
-			// Make a copy
-			mData = new std::pair<K,V>* [other.mCapacity];
-			mCapacity = other.mCapacity;
-			mSize = other.mSize;
-			for (int i = 0; i < mCapacity; i++)
+			if (this != &other)
 			{
-				if (other.mData[i])
-					mData[i] = new std::pair<K,V>(*other.mData[i]);
-				else
-					mData[i] = nullptr;
+				release();
+				copy_from(other);
 			}
 
 			// Return us
@@ -196,6 +194,25 @@ namespace ssuds
 		}
 
 
+		/// move-=operator
+		UnorderedMap& operator=(UnorderedMap&& other)
+		{
+			if (this != &other)
+			{
+				release();
+				mData = other.mData;
+				mControl = other.mControl;
+				mSize = other.mSize;
+				mCapacity = other.mCapacity;
+				other.mData = nullptr;
+				other.mControl = nullptr;
+				other.mSize = 0;
+				other.mCapacity = 0;
+			}
+			return *this;
+		}
+
+
 		/// Outputs the unorderd map in this form: {keyA: valueA, keyC: valueC, keyB: valueB}
 		/// Note that this is an unordered set, so the output is in some arbitrary order
 		friend std::ostream& operator<<(std::ostream& os, const UnorderedMap& m)
@@ -207,62 +224,45 @@ namespace ssuds
 
 		/// This is the most fundamental, but also trickier methods.  It is the way maps add
 		/// and modify elements.  The trick is, we use the key to find the right spot.  If the
-		/// elements not there (which means this is an add), we make a new entry with the value
-		/// uninitialized BUT also return a reference to the value.  If the user changes it like
+		/// elements not there (which means this is an add), we make a new entry with a
+		/// default-constructed value BUT also return a reference to the value.  If the user changes it like
 		/// my_list[my_key] = my_value;
-		/// then the new entry is fully initialized.  But if the user does
-		/// my_list[my_key];
-		/// it would create the entry, but the value will be some uninitialized value.  std::unordered_map's
-		/// also have this same behavior.
+		/// then the new entry is fully initialized.  std::unordered_map's also have this same behavior.
+		/// Note: since the pairs are stored inline, adding an element may move the others (so references
+		/// to values are only good until the next add)
 		V& operator[](const K& key)
 		{
-			size_t index = find_spot(key);
-			if (mData[index] == NULL)
+			size_t hash = hash_of(key);
+			size_t index = find_spot(key, hash);
+			if (!is_full(mControl[index]))
 			{
-				// That value isn't in here.  Create it and return 
-				// a reference to the new node's value.
-				mData[index] = new std::pair<K, V>;
-				mData[index]->first = key;
-				mSize++;
+				// That value isn't in here.  Make room if needed (the index will almost surely be
+				// different if we grew), then create it in place and return a reference to the new value.
 				if (check_for_capacity())
-				{
-					// The index will almost surely be different if we grew
-					index = find_spot(key);
-				}
-				return mData[index]->second;
-			}
-			else
-			{
-				// We do have that item.  Return it to them -- they
-				// can use it or modify it (since it's a reference)
-				return mData[index]->second;
+					index = find_spot(key, hash);
+				new (&mData[index]) std::pair<K, V>(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+				set_control(index, hash_fragment(hash));
+				mSize++;
 			}
+
+			// Either way, return the value -- they can use it or modify it (since it's a reference)
+			return mData[index].second;
 		}
 
 
 		/// Removes all elements and sets the array back to its initial (INITIAL_MAP_CAPACITY) capacity
 		void clear() 
 		{
-			// Delete the non-null nodes
-			for (int i = 0; i < mCapacity; i++)
-				delete mData[i];
-
-			// Delete the array itself
-			delete[] mData;
-
-			// Reset things
-			mCapacity = INITIAL_MAP_CAPACITY;
-			mData = new std::pair<K,V> * [mCapacity];
-			mSize = 0;
-			memset(mData, 0, sizeof(std::pair<K,V>*) * mCapacity);
+			release();
+			allocate(INITIAL_MAP_CAPACITY);
 		}
 
 
 		/// Returns true if we have a pair with this key
 		UnorderedMapIterator find(const K& key) const
 		{
-			size_t index = find_spot(key);
-			if (mData[index])
+			size_t index = find_spot(key, hash_of(key));
+			if (is_full(mControl[index]))
 				return UnorderedMapIterator(this, index);
 			else
 				return end();
@@ -277,31 +277,31 @@ namespace ssuds
 			bool first = true;
 			if (show_nulls)
 			{
-				for (int i = 0; i < mCapacity; i++)
+				for (size_t i = 0; i < mCapacity; i++)
 				{
 					if (!first)
 						os << ", ";
 					else
 						first = false;
 
-					if (mData[i] == NULL)
+					if (!is_full(mControl[i]))
 						os << "NULL";
 					else
-						os << mData[i]->first << ":" << mData[i]->second;
+						os << mData[i].first << ":" << mData[i].second;
 				}
 			}
 			else
 			{
-				for (int i = 0; i < mCapacity; i++)
+				for (size_t i = 0; i < mCapacity; i++)
 				{
-					if (mData[i] != NULL)
+					if (is_full(mControl[i]))
 					{
 						if (!first)
 							os << ", ";
 						else
 							first = false;
 
-						os << mData[i]->first << ":" << mData[i]->second;
+						os << mData[i].first << ":" << mData[i].second;
 					}
 				}
 			}
@@ -311,59 +311,76 @@ namespace ssuds
 
 		/// Removes the pair with the given key and returns the corresponding value.  It 
 		/// raises an out_of_range exception if not (the user should check for existence first
-		/// with the find method)
+		/// with the find method).  This uses backward-shift deletion: the pairs after the hole (up to
+		/// the next empty slot) that could live closer to their home slot are moved back one at a time,
+		/// so no tombstones are left behind and nothing is allocated or re-hashed into a new table
 		V remove(const K& key)
 		{
-			size_t index = find_spot(key);
-			size_t start_index = index;
-			bool found_it = false;
-			V found_val;
-			bool found_null = false;
+			size_t index = find_spot(key, hash_of(key));
+			if (!is_full(mControl[index]))
+				throw std::out_of_range("The value doesn't exist in the map");
 
-			// First, collect all the values we find after that index until we
-			// find a NULL.
-			ArrayList<K> keys_to_readd;
-			ArrayList<V> values_to_readd;
+			V found_val = std::move(mData[index].second);
+			mData[index].~pair();
 
-			while (true)
+			size_t mask = mCapacity - 1;
+			size_t hole = index;
+			size_t cur_index = (hole + 1) & mask;
+			while (is_full(mControl[cur_index]))
 			{
-				if (mData[index] == NULL)
+				// This pair can fill the hole if the hole isn't before its home slot (i.e. the
+				// hole is no further from cur_index than its home slot is)
+				size_t home = home_slot(hash_of(mData[cur_index].first));
+				if (((cur_index - home) & mask) >= ((cur_index - hole) & mask))
 				{
-					found_null = true;
-					break;
+					new (&mData[hole]) std::pair<K, V>(std::move(mData[cur_index]));
+					mData[cur_index].~pair();
+					set_control(hole, mControl[cur_index]);
+					hole = cur_index;
 				}
-				else
-				{
-					if (mData[index]->first == key)
-					{
-						found_val = mData[index]->second;
-						found_it = true;
-					}
-					else
-					{
-						keys_to_readd.append(mData[index]->first);
-						values_to_readd.append(mData[index]->second);
-					}
-					delete mData[index];
-					mData[index] = NULL;
-				}
-				++index;
-				if (index == start_index)
-					throw std::out_of_range("invalid heap state");
-				else if (index == mCapacity)
-					index = 0;
+				cur_index = (cur_index + 1) & mask;
 			}
-
-			// Now, re-add any key-value pairs that we removed along the way
-			mSize -= keys_to_readd.size() + 1;
-			for (int i = 0; i < (int)keys_to_readd.size(); i++)
-				(*this)[keys_to_readd[i]] = values_to_readd[i];
+			set_control(hole, msEmptySlot);
+			mSize--;
 
 			// Return the removed element
-			if (found_it)
-				return found_val;
-			else
-				throw std::out_of_range("The value doesn't exist in the map");
+			return found_val;
+		}
+
+
+		/// Makes sure the table can hold num_pairs pairs without growing (so adding that many
+		/// does no re-hashing).  This never shrinks the table
+		void reserve(size_t num_pairs)
+		{
+			size_t needed = capacity_for(num_pairs);
+			if (needed > mCapacity)
+				resize_table(needed);
+		}
+
+
+		/// Re-builds the table with at least num_slots slots (rounded up to a power of two, and never
+		/// fewer than the current pairs need).  This can be used to shrink a table after many removals
+		void rehash(size_t num_slots)
+		{
+			size_t new_capacity = capacity_for(mSize);
+			while (new_capacity < num_slots)
+				new_capacity <<= 1;
+			if (new_capacity != mCapacity)
+				resize_table(new_capacity);
+		}
+
+
+		/// Adds (or updates) every key-value pair in the range [first, last) -- e.g. from another map or
+		/// an ArrayList of std::pairs.  The range is counted first so the table grows at most once
+		template <class I>
+		void insert(I first, I last)
+		{
+			size_t count = 0;
+			for (I it = first; it != last; ++it)
+				count++;
+			reserve(mSize + count);
+			for (; first != last; ++first)
+				(*this)[(*first).first] = (*first).second;
 		}
 
 
@@ -382,78 +399,236 @@ namespace ssuds
 		
 
 	protected:
-		/// This method is used internally by check_for_capacity.  If we decide 
-		/// that we need to grow, we can remove and re-add (using the [] operator),
-		/// but if the thing we're adding is complex, deleting it and re-adding it
-		/// could cause problems (in that case, this method is better)
-		void internal_add(std::pair<K,V>* pair)
-		{
-			size_t index = find_spot(pair->first);
-			if (mData[index] == NULL)
+		/// Allocates (uninitialized) storage for capacity pairs (a power of two), with every slot marked empty,
+		/// and makes it our table.  mData / mControl / mCapacity are only replaced once both arrays have been
+		/// allocated, so if an allocation throws, the map is unchanged (and the caller still owns the old arrays)
+		void allocate(size_t capacity)
+		{
+			std::pair<K, V>* data = static_cast<std::pair<K, V>*>(::operator new(sizeof(std::pair<K, V>) * capacity));
+			unsigned char* control;
+			try
 			{
-				// That value isn't in here.  Create it and return 
-				// a reference to the new node's value.
-				mData[index] = pair;
+				control = new unsigned char[capacity + msGroupWidth - 1];
 			}
-			else
-				throw std::runtime_error("Invalid heap state in grow");
+			catch (...)
+			{
+				::operator delete(data);
+				throw;
+			}
+			memset(control, msEmptySlot, capacity + msGroupWidth - 1);
+			mData = data;
+			mControl = control;
+			mCapacity = capacity;
 		}
 
 
-		/// A helper method which returns the index at which the key-value pair with the given key
-		/// *does* appear or *would* appear (if it were in the table)
-		size_t find_spot(const K& key) const
+		/// Destroys all the pairs and frees the storage (leaving the map in the "moved-from" state)
+		void release()
+		{
+			if (mControl)
+			{
+				for (size_t i = 0; i < mCapacity; i++)
+				{
+					if (is_full(mControl[i]))
+						mData[i].~pair();
+				}
+			}
+			::operator delete(mData);
+			delete[] mControl;
+			mData = nullptr;
+			mControl = nullptr;
+			mSize = 0;
+			mCapacity = 0;
+		}
+
+
+		/// Makes us a copy of m (our storage must already be released).  We shouldn't need to re-hash
+		/// anything since our table capacity is the same size
+		void copy_from(const UnorderedMap& m)
 		{
-			size_t start_index = mHashGenerator(key) % mCapacity;
-			size_t cur_index = start_index;
-			for (; cur_index < (int)mCapacity; cur_index++)
+			allocate(m.mCapacity);
+			mSize = m.mSize;
+			for (size_t i = 0; i < mCapacity; i++)
 			{
-				if (mData[cur_index] == NULL || mData[cur_index]->first == key)
-					return cur_index;
+				if (is_full(m.mControl[i]))
+					new (&mData[i]) std::pair<K, V>(m.mData[i]);
 			}
+			memcpy(mControl, m.mControl, mCapacity + msGroupWidth - 1);
+		}
+
 
-			// If we get here, we didn't find it yet, loop back to the beginning
-			for (cur_index = 0; cur_index < start_index; cur_index++)
+		/// This method is used internally by check_for_capacity to move an existing pair into the
+		/// (freshly allocated) table without copying it
+		void internal_add(std::pair<K, V>&& pair)
+		{
+			size_t hash = hash_of(pair.first);
+			size_t index = find_spot(pair.first, hash);
+			if (!is_full(mControl[index]))
 			{
-				if (mData[cur_index] == NULL || mData[cur_index]->first == key)
-					return cur_index;
+				new (&mData[index]) std::pair<K, V>(std::move(pair));
+				set_control(index, hash_fragment(hash));
 			}
+			else
+				throw std::runtime_error("Invalid heap state in grow");
+		}
 
-			// If we get here, the grow operation is not working properly
-			throw std::out_of_range("Invalid state: empty hash table");
+
+		/// Is this the control byte of a slot holding a pair?
+		static bool is_full(unsigned char control)
+		{
+			return (control & msEmptySlot) == 0;
 		}
 
 
-		/// Helper function used to "grow" the table.  I could (but currently don't) shrink the table
-		bool check_for_capacity()
+		/// Hashes a key.  std::hash is the identity function for integers on most compilers, which would
+		/// put runs of consecutive keys in one long cluster, so we scramble it (Fibonacci hashing) and fold
+		/// the well-mixed high bits down
+		size_t hash_of(const K& key) const
+		{
+			std::uint64_t h = (std::uint64_t)mHashGenerator(key) * 0x9E3779B97F4A7C15ull;
+			return (size_t)(h ^ (h >> 32));
+		}
+
+
+		/// The 7 bits of a hash stored in the control byte
+		static unsigned char hash_fragment(size_t hash)
 		{
-			float cur_capacity = (float)mSize / mCapacity;
-			if (cur_capacity > MAX_LOAD_FACTOR)
+			return (unsigned char)(hash & 0x7F);
+		}
+
+
+		/// The slot where probing for a key with this hash starts (the bits not used by hash_fragment)
+		size_t home_slot(size_t hash) const
+		{
+			return (hash >> 7) & (mCapacity - 1);
+		}
+
+
+		/// Sets the control byte of a slot (and its mirror(s) past the end of the table)
+		void set_control(size_t index, unsigned char control)
+		{
+			mControl[index] = control;
+			for (size_t mirror = index + mCapacity; mirror < mCapacity + msGroupWidth - 1; mirror += mCapacity)
+				mControl[mirror] = control;
+		}
+
+
+		/// Compares the msGroupWidth control bytes starting at group with value.  Bit i of the
+		/// result is set if group[i] == value
+		static unsigned int match_group(const unsigned char* group, unsigned char value)
+		{
+#if SSUDS_MAP_SSE2
+			__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+			return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)value)));
+#else
+			unsigned int result = 0;
+			for (unsigned int i = 0; i < msGroupWidth; i++)
 			{
-				// Collect all the key-value pairs
-				ArrayList<std::pair<K,V>*> pairs;
-				for (int i = 0; i < mCapacity; i++)
+				if (group[i] == value)
+					result |= 1u << i;
+			}
+			return result;
+#endif
+		}
+
+
+		/// Returns the position of the lowest set bit (bits must not be 0)
+		static unsigned int lowest_bit(unsigned int bits)
+		{
+#if defined(_MSC_VER)
+			unsigned long pos;
+			_BitScanForward(&pos, bits);
+			return (unsigned int)pos;
+#else
+			return (unsigned int)__builtin_ctz(bits);
+#endif
+		}
+
+
+		/// A helper method which returns the index at which the key-value pair with the given key
+		/// *does* appear or *would* appear (if it were in the table).  hash must be hash_of(key).
+		/// Probing is linear, but a group of msGroupWidth slots at a time: keys are only compared in
+		/// slots whose control byte holds the same hash fragment, and the search stops at the first
+		/// group with an empty slot
+		size_t find_spot(const K& key, size_t hash) const
+		{
+			size_t mask = mCapacity - 1;
+			unsigned char fragment = hash_fragment(hash);
+			size_t cur_index = home_slot(hash);
+			for (size_t probed = 0; probed < mCapacity; probed += msGroupWidth)
+			{
+				const unsigned char* group = mControl + cur_index;
+				unsigned int matches = match_group(group, fragment);
+				while (matches)
 				{
-					if (mData[i] != NULL)
-						pairs.append(mData[i]);
+					size_t index = (cur_index + lowest_bit(matches)) & mask;
+					if (mData[index].first == key)
+						return index;
+					matches &= matches - 1;
 				}
+				unsigned int empties = match_group(group, msEmptySlot);
+				if (empties)
+					return (cur_index + lowest_bit(empties)) & mask;
+				cur_index = (cur_index + msGroupWidth) & mask;
+			}
 
-				// Re-allocate the array (doubling)
-				mCapacity <<= 1;					// bit-shift one place (double)
-				delete[] mData;
-				mData = new std::pair<K,V> * [mCapacity];
-				memset(mData, 0, sizeof(std::pair<K,V>*) * mCapacity);
+			// If we get here, the grow operation is not working properly
+			throw std::out_of_range("Invalid state: empty hash table");
+		}
 
-				// Re-add all the key-value pairs
-				for (int i = 0; i < (int)pairs.size(); i++)
-					internal_add(pairs[i]);
 
+		/// Helper function used (just before adding a pair) to "grow" the table if one more pair would put
+		/// the load factor over MAX_LOAD_FACTOR.  Returns true if we grew.  I could (but currently don't) shrink the table
+		bool check_for_capacity()
+		{
+			if (needs_growth(mSize + 1, mCapacity))
+			{
+				resize_table(mCapacity << 1);			// bit-shift one place (double)
 				return true;
 			}
 			else
 				return false;
 		}
 
+
+		/// Returns true if num_pairs pairs would put a table of the given capacity over MAX_LOAD_FACTOR
+		static bool needs_growth(size_t num_pairs, size_t capacity)
+		{
+			return (float)num_pairs / capacity > MAX_LOAD_FACTOR;
+		}
+
+
+		/// Returns the smallest power-of-two capacity (at least INITIAL_MAP_CAPACITY) that holds num_pairs pairs
+		static size_t capacity_for(size_t num_pairs)
+		{
+			size_t capacity = INITIAL_MAP_CAPACITY;
+			while (needs_growth(num_pairs, capacity))
+				capacity <<= 1;
+			return capacity;
+		}
+
+
+		/// Re-allocates the arrays with the given (power-of-two) capacity and moves all the pairs over
+		void resize_table(size_t new_capacity)
+		{
+			std::pair<K, V>* old_data = mData;
+			unsigned char* old_control = mControl;
+			size_t old_capacity = mCapacity;
+			allocate(new_capacity);
+
+			// Move all the key-value pairs over
+			for (size_t i = 0; i < old_capacity; i++)
+			{
+				if (is_full(old_control[i]))
+				{
+					internal_add(std::move(old_data[i]));
+					old_data[i].~pair();
+				}
+			}
+			::operator delete(old_data);
+			delete[] old_control;
+		}
+
 	public:
 		
 		/// Returns an iterator to the first value in the map, if there is one (this iterator will
@@ -45,7 +45,7 @@ int main()
                 }
                 if (event.mouseButton.button == sf::Mouse::Right)
                 {
-                    GC.depth_first(trav, 0, -1);
+                    GC.depth_first(trav, 0);
                 }
             }
         }
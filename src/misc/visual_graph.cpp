@@ -132,72 +132,52 @@ void misc::VisualGraph::print_trav(std::map<int, float>& traversal_map)
 
 /// <summary>
 /// This function will perform breadth first traversal for the given set of nodes and edges. It will start from the 
-/// starting node and move one pass of edges each time until all branches are reached
+/// starting node and move one pass of edges each time until all branches are reached.  The work is done by
+/// ssuds::BreadthFirstSearch on a packed snapshot of the graph.
 /// </summary>
 /// <param name="traversal_map">A temporary map to hold the travel history of the function</param>
 /// <param name="start_node">Tells the function what node to start at</param>
 void misc::VisualGraph::breadth_first(std::map<int, float>& traversal_map, int start_node)
 {
-	ssuds::ArrayList<int> frontier = { start_node };
-	traversal_map[start_node] = -1;
-	while (frontier.size() > 0)
-	{
-		ssuds::ArrayList<int> new_frontier = {};
+	if (!mInternalGraph.contains_node(start_node))
+		return;
 
-		for (unsigned int i = 0; i < frontier.size(); i++)
-		{
-			ssuds::UnorderedMap<int, ssuds::UnorderedMap<int, float>>::UnorderedMapIterator it = mInternalGraph.find(frontier[i]);
-			if (it != mInternalGraph.end())
-			{
-				int cur_node = frontier[i];
-				for (std::pair<int, float> p : (*it).second)
-				{
-					int id = p.first;
-					if (traversal_map.find(id) == traversal_map.end())
-					{
-						traversal_map[id] = cur_node;
-						std::cout << cur_node;
-						new_frontier.append(id);
-					}
-				}
-			}
-		}
-		frontier = new_frontier;
+	ssuds::BreadthFirstSearch<int, float> bfs(mInternalGraph);
+	bfs.run(start_node);
+	const ssuds::CsrGraph<int, float>& snapshot = bfs.graph();
+	for (unsigned int i = 0; i < snapshot.num_nodes(); i++)
+	{
+		int parent = bfs.parent(i);
+		if (parent >= 0)
+			traversal_map[snapshot.node_at(i)] = (float)snapshot.node_at(parent);
 	}
+	traversal_map[start_node] = -1;
 	print_trav(traversal_map);
 }
 
 /// <summary>
-/// This function performs a depth first movement through the given set of nodes and edges. This function
-/// will move through each node recursively until it reaches a node with no edges to move through. Then it
-/// will step back and explore any branches that were not explored through the recursive calls.
+/// This function performs a depth first movement through the given set of nodes and edges. It follows
+/// each branch until it reaches a node with no unexplored edges, then steps back and explores any branches
+/// that were skipped.  The work is done by ssuds::DepthFirstSearch, which keeps an explicit stack, so long
+/// paths can't overflow the call stack.
 /// </summary>
 /// <param name="traversal_map">A temporary map to hold the travel history of the function</param>
 /// <param name="start_node">tells the function where to begin</param>
-/// <param name="cur_node">a dummy value that tells the function where it currently is</param>
-void misc::VisualGraph::depth_first(std::map<int, float>& traversal_map, int start_node, int cur_node = -1)
+void misc::VisualGraph::depth_first(std::map<int, float>& traversal_map, int start_node)
 {
-	if (cur_node == -1)
-	{
-		traversal_map[start_node] = -1;
-		depth_first(traversal_map, start_node, start_node);
-	}
-	else
+	if (!mInternalGraph.contains_node(start_node))
+		return;
+
+	ssuds::DepthFirstSearch<int, float> dfs(mInternalGraph);
+	dfs.run(start_node);
+	const ssuds::CsrGraph<int, float>& snapshot = dfs.graph();
+	for (unsigned int i = 0; i < snapshot.num_nodes(); i++)
 	{
-		ssuds::UnorderedMap<int, ssuds::UnorderedMap<int, float>>::UnorderedMapIterator it = mInternalGraph.find(cur_node);
-		if (it != mInternalGraph.end())
-		{
-			for (std::pair<int, float> p : (*it).second)
-			{
-				int id = p.first;
-				if (traversal_map.find(id) == traversal_map.end())
-				{
-					traversal_map[id] = cur_node;
-					depth_first(traversal_map, start_node, id);
-				}
-			}
-		}
+		int parent = dfs.parent(i);
+		if (parent >= 0)
+			traversal_map[snapshot.node_at(i)] = (float)snapshot.node_at(parent);
 	}
+	traversal_map[start_node] = -1;
 	print_trav(traversal_map);
 }
 
@@ -1,7 +1,9 @@
 #include <gtest/gtest.h>
 #include <array_list.h>
+#include <memory>
+#include <algorithm>
 
-#define EXECUTE_ARRAY_LIST_TESTS 0
+#define EXECUTE_ARRAY_LIST_TESTS 1
 #if EXECUTE_ARRAY_LIST_TESTS
 
 
@@ -23,7 +25,10 @@ TEST(ArrayListTests, FoundationalItems)
 	EXPECT_EQ(slist1[0], 10);
 	EXPECT_EQ(slist1[1], 11);
 	EXPECT_EQ(slist1[2], 12);
+#if SSUDS_CHECKED_ACCESS
 	EXPECT_THROW(slist1[3], std::out_of_range);
+#endif
+	EXPECT_THROW(slist1.at(3), std::out_of_range);
 	slist1.clear();
 	EXPECT_EQ(slist1.size(), 0);
 }
@@ -233,8 +238,8 @@ TEST(ArrayListTests, ReverseIteration)
 	slist2.append("B");
 	slist2.append("C");
 	slist2.append("D");
-	ssuds::ArrayList<std::string>::ArrayListIterator it = slist2.rbegin();
-	ssuds::ArrayList<std::string>::ArrayListIterator it_end = slist2.rend();
+	ssuds::ArrayList<std::string>::ArrayListReverseIterator it = slist2.rbegin();
+	ssuds::ArrayList<std::string>::ArrayListReverseIterator it_end = slist2.rend();
 	std::string val1, val2, val3, val4;
 	ASSERT_NE(it, it_end);
 	val1 = *it;
@@ -251,13 +256,15 @@ TEST(ArrayListTests, ReverseIteration)
 	EXPECT_EQ(val4, "A");
 	EXPECT_EQ(it, it_end);
 
-	// Make sure r/not-r object interact right
+	// Make sure r/not-r object interact right (a reverse iterator's base is the forward
+	// iterator one past the value it refers to)
 	it = slist2.rbegin();
 	it_end = slist2.rend();
 	ssuds::ArrayList<std::string>::ArrayListIterator fit = slist2.begin();
 	ssuds::ArrayList<std::string>::ArrayListIterator fit_end = slist2.end();
-	EXPECT_NE(it, fit_end);
-	EXPECT_NE(it_end, fit);
+	EXPECT_EQ(it.base(), fit_end);
+	EXPECT_EQ(it_end.base(), fit);
+	EXPECT_EQ(*it, *(fit_end - 1));
 }
 
 TEST(ArrayListTests, PrettyIteration)
@@ -380,4 +387,317 @@ TEST(ArrayListTests, SimpleIterator)
 	EXPECT_EQ(it, a.end());
 }
 
+
+/// Counts copies, so we can check that growing / inserting / removing only moves elements
+class CopyCounter
+{
+public:
+	static int msCopies;
+	std::string mValue;
+	CopyCounter() { }
+	CopyCounter(const std::string& value) : mValue(value) { }
+	CopyCounter(const CopyCounter& other) : mValue(other.mValue) { msCopies++; }
+	CopyCounter(CopyCounter&& other) : mValue(std::move(other.mValue)) { }
+	CopyCounter& operator=(const CopyCounter& other) { mValue = other.mValue; msCopies++; return *this; }
+	CopyCounter& operator=(CopyCounter&& other) { mValue = std::move(other.mValue); return *this; }
+};
+int CopyCounter::msCopies = 0;
+
+
+TEST(ArrayListTests, MovesInsteadOfCopies)
+{
+	CopyCounter::msCopies = 0;
+	ssuds::ArrayList<CopyCounter> a;
+	for (int i = 0; i < 1000; i++)
+		a.append(CopyCounter(std::to_string(i)));
+	a.insert(CopyCounter("front"), 0);
+	a.emplace_back("back");
+	EXPECT_EQ(a.remove(500).mValue, "499");
+	for (int i = 0; i < 900; i++)
+		a.remove(a.size() - 1);
+	EXPECT_EQ(CopyCounter::msCopies, 0);
+	ASSERT_EQ(a.size(), 101);
+	EXPECT_EQ(a[0].mValue, "front");
+	EXPECT_EQ(a[100].mValue, "99");
+
+	// Appending a copy of one of our own elements works even when it triggers a grow
+	ssuds::ArrayList<std::string> s;
+	for (int i = 0; i < 5; i++)
+		s.append(std::to_string(i));
+	ASSERT_EQ(s.size(), s.capacity());
+	s.append(s[0]);
+	EXPECT_EQ(s[5], "0");
+}
+
+
+TEST(ArrayListTests, MoveOnlyElements)
+{
+	ssuds::ArrayList<std::unique_ptr<int>> a;
+	for (int i = 0; i < 20; i++)
+		a.emplace_back(new int(i));
+	a.insert(std::unique_ptr<int>(new int(-1)), 3);
+	std::unique_ptr<int> removed = a.remove(0);
+	EXPECT_EQ(*removed, 0);
+	ASSERT_EQ(a.size(), 20);
+	EXPECT_EQ(*a[0], 1);
+	EXPECT_EQ(*a[2], -1);
+	EXPECT_EQ(*a[19], 19);
+
+	ssuds::ArrayList<std::unique_ptr<int>> b;
+	b = std::move(a);
+	EXPECT_EQ(a.size(), 0);
+	EXPECT_EQ(b.size(), 20);
+}
+
+
+TEST(ArrayListTests, SelfAssignment)
+{
+	ssuds::ArrayList<std::string> a{ "x", "y", "z" };
+	ssuds::ArrayList<std::string>& alias = a;
+	a = alias;
+	ASSERT_EQ(a.size(), 3);
+	EXPECT_EQ(a[2], "z");
+}
+
+
+/// A type with no default constructor that tracks how many instances are alive
+class Tracked
+{
+public:
+	static int msLive;
+	int mValue;
+	Tracked(int value) : mValue(value) { msLive++; }
+	Tracked(const Tracked& other) : mValue(other.mValue) { msLive++; }
+	Tracked& operator=(const Tracked& other) { mValue = other.mValue; return *this; }
+	~Tracked() { msLive--; }
+};
+int Tracked::msLive = 0;
+
+
+TEST(ArrayListTests, OnlyLiveElementsAreConstructed)
+{
+	{
+		ssuds::ArrayList<Tracked> a;
+		a.reserve(100);
+		EXPECT_EQ(a.capacity(), 100);
+		EXPECT_EQ(Tracked::msLive, 0);
+		for (int i = 0; i < 10; i++)
+			a.append(Tracked(i));
+		EXPECT_EQ(Tracked::msLive, 10);
+		EXPECT_EQ(a.capacity(), 100);
+
+		a.insert(Tracked(-1), 4);
+		EXPECT_EQ(Tracked::msLive, 11);
+		EXPECT_EQ(a.remove(0, false).mValue, 0);
+		EXPECT_EQ(Tracked::msLive, 10);
+		EXPECT_EQ(a[3].mValue, -1);
+
+		a.shrink_to_fit();
+		EXPECT_EQ(a.capacity(), 10);
+		EXPECT_EQ(a[9].mValue, 9);
+
+		ssuds::ArrayList<Tracked> b(a);
+		EXPECT_EQ(Tracked::msLive, 20);
+		b = a;
+		EXPECT_EQ(Tracked::msLive, 20);
+		b.clear();
+		EXPECT_EQ(Tracked::msLive, 10);
+		EXPECT_EQ(b.capacity(), 0);
+
+		// reserve never reduces the capacity
+		a.reserve(3);
+		EXPECT_EQ(a.capacity(), 10);
+	}
+	EXPECT_EQ(Tracked::msLive, 0);
+
+	ssuds::ArrayList<int> empty;
+	empty.shrink_to_fit();
+	EXPECT_EQ(empty.capacity(), 0);
+	empty.append(5);
+	EXPECT_EQ(empty[0], 5);
+}
+
+
+TEST(ArrayListTests, GrowthPolicies)
+{
+	// The default policy doubles and halves
+	ssuds::ArrayList<int> d;
+	for (int i = 0; i < 6; i++)
+		d.append(i);
+	EXPECT_EQ(d.capacity(), 10);
+	for (int i = 0; i < 2; i++)
+		d.remove(0);
+	EXPECT_EQ(d.capacity(), 5);
+
+	ssuds::ArrayList<int, ssuds::OneAndAHalfGrowthPolicy> h;
+	ssuds::ArrayList<unsigned int> capacities;
+	for (int i = 0; i < 16; i++)
+	{
+		h.append(i);
+		if (capacities.size() == 0 || capacities[capacities.size() - 1] != h.capacity())
+			capacities.append(h.capacity());
+	}
+	ASSERT_EQ(capacities.size(), 5);
+	EXPECT_EQ(capacities[0], 5);
+	EXPECT_EQ(capacities[1], 7);
+	EXPECT_EQ(capacities[2], 10);
+	EXPECT_EQ(capacities[3], 15);
+	EXPECT_EQ(capacities[4], 22);
+
+	ssuds::ArrayList<int, ssuds::NoShrinkGrowthPolicy> n;
+	for (int i = 0; i < 100; i++)
+		n.append(i);
+	unsigned int cap = n.capacity();
+	while (n.size() > 0)
+		n.remove(0);
+	EXPECT_EQ(n.capacity(), cap);
+	n.shrink_to_fit();
+	EXPECT_EQ(n.capacity(), 0);
+
+	// A size bouncing around a power of two re-allocates every time with halving at 1/2, but not with hysteresis
+	ssuds::ArrayList<int> thrash;
+	ssuds::ArrayList<int, ssuds::HysteresisGrowthPolicy> steady;
+	for (int i = 0; i < 40; i++)
+	{
+		thrash.append(i);
+		steady.append(i);
+	}
+	unsigned int thrash_changes = 0, steady_changes = 0;
+	for (int round = 0; round < 10; round++)
+	{
+		for (int i = 0; i < 42; i++)
+		{
+			unsigned int before = thrash.capacity(), steady_before = steady.capacity();
+			if (i < 21)
+			{
+				thrash.remove(thrash.size() - 1);
+				steady.remove(steady.size() - 1);
+			}
+			else
+			{
+				thrash.append(i);
+				steady.append(i);
+			}
+			thrash_changes += thrash.capacity() != before;
+			steady_changes += steady.capacity() != steady_before;
+		}
+	}
+	EXPECT_GT(thrash_changes, 0);
+	EXPECT_EQ(steady_changes, 0);
+	EXPECT_EQ(steady.size(), 40);
+	EXPECT_EQ(thrash.size(), 40);
+	EXPECT_EQ(steady[39], 41);
+}
+
+
+TEST(ArrayListTests, SmallArrayList)
+{
+	ssuds::SmallArrayList<std::string, 4> a;
+	EXPECT_EQ(a.capacity(), 4);
+	a.append("a");
+	a.append("b");
+	a.append("c");
+	a.append("d");
+	EXPECT_EQ(a.capacity(), 4);
+	const char* object_start = reinterpret_cast<const char*>(&a);
+	const char* first = reinterpret_cast<const char*>(&a[0]);
+	EXPECT_TRUE(first >= object_start && first < object_start + sizeof(a));
+
+	// Copies and moves of an inline list
+	ssuds::SmallArrayList<std::string, 4> b(a);
+	ssuds::SmallArrayList<std::string, 4> c(std::move(b));
+	EXPECT_EQ(b.size(), 0);
+	ASSERT_EQ(c.size(), 4);
+	EXPECT_EQ(c[3], "d");
+
+	// Spilling to the heap and coming back
+	a.append("e");
+	EXPECT_GT(a.capacity(), 4);
+	EXPECT_EQ(a[4], "e");
+	ssuds::SmallArrayList<std::string, 4> d;
+	d = std::move(a);
+	EXPECT_EQ(a.size(), 0);
+	EXPECT_EQ(a.capacity(), 4);
+	ASSERT_EQ(d.size(), 5);
+	d.remove(0);
+	d.remove(0);
+	d.shrink_to_fit();
+	EXPECT_EQ(d.capacity(), 4);
+	EXPECT_EQ(d[0], "c");
+	EXPECT_EQ(d[2], "e");
+	d = c;
+	EXPECT_EQ(d.size(), 4);
+	d.clear();
+	EXPECT_EQ(d.capacity(), 4);
+	EXPECT_EQ(c[0], "a");
+}
+
+
+TEST(ArrayListTests, AtAndData)
+{
+	ssuds::ArrayList<int> a{ 3, 1, 4, 1, 5 };
+	EXPECT_EQ(a.at(2), 4);
+	a.at(2) = 9;
+	EXPECT_EQ(a[2], 9);
+	EXPECT_THROW(a.at(5), std::out_of_range);
+#if SSUDS_CHECKED_ACCESS
+	EXPECT_THROW(a[5], std::out_of_range);
+#endif
+
+	int* p = a.data();
+	ASSERT_NE(p, nullptr);
+	EXPECT_EQ(p, &a[0]);
+	int total = 0;
+	for (unsigned int i = 0; i < a.size(); i++)
+		total += p[i];
+	EXPECT_EQ(total, 19);
+
+	const ssuds::ArrayList<int>& ca = a;
+	EXPECT_EQ(ca.data()[4], 5);
+
+	ssuds::ArrayList<int> empty;
+	EXPECT_EQ(empty.data(), nullptr);
+}
+
+
+TEST(ArrayListTests, RandomAccessIterator)
+{
+	ssuds::ArrayList<int> a{ 5, 8, 9, 3, 1, 2, 7, 0 };
+	ssuds::ArrayList<int>::ArrayListIterator it = a.begin();
+	EXPECT_EQ(a.end() - a.begin(), 8);
+	EXPECT_EQ(it[2], 9);
+	EXPECT_EQ(*(it + 3), 3);
+	EXPECT_EQ(*(3 + it), 3);
+	it += 7;
+	EXPECT_EQ(*it, 0);
+	it -= 2;
+	EXPECT_EQ(*it--, 2);
+	EXPECT_EQ(*it, 1);
+	EXPECT_TRUE(a.begin() < it && it <= a.end());
+
+	// STL algorithms work directly on an ArrayList
+	std::sort(a.begin(), a.end());
+	int sorted[] = { 0, 1, 2, 3, 5, 7, 8, 9 };
+	for (unsigned int i = 0; i < a.size(); i++)
+		EXPECT_EQ(a[i], sorted[i]);
+	EXPECT_EQ(std::lower_bound(a.begin(), a.end(), 7) - a.begin(), 5);
+	EXPECT_TRUE(std::binary_search(a.begin(), a.end(), 8));
+	EXPECT_FALSE(std::binary_search(a.begin(), a.end(), 4));
+
+	// Reverse iterators work with them too
+	ssuds::ArrayList<int> reversed;
+	for (ssuds::ArrayList<int>::ArrayListReverseIterator rit = a.rbegin(); rit != a.rend(); ++rit)
+		reversed.append(*rit);
+	EXPECT_EQ(reversed[0], 9);
+	EXPECT_EQ(reversed[7], 0);
+	std::sort(a.rbegin(), a.rend());
+	EXPECT_EQ(a[0], 9);
+	EXPECT_EQ(a[7], 0);
+
+	// -> works on class elements
+	ssuds::ArrayList<std::string> s{ "abc", "de" };
+	EXPECT_EQ(s.begin()->size(), 3);
+	EXPECT_EQ(s.rbegin()->size(), 2);
+}
+
 #endif
\ No newline at end of file
@@ -1,8 +1,16 @@
 #include <gtest/gtest.h>
 #include <array_list.h>
 #include <array_list_utility.h>
-
-#define DO_ARRAY_LIST_UTILITY_TESTS 0
+#include <algorithm>
+#include <random>
+#include <string>
+#include <functional>
+#include <limits>
+#include <cstdlib>
+#include <atomic>
+#include <stdexcept>
+
+#define DO_ARRAY_LIST_UTILITY_TESTS 1
 #if DO_ARRAY_LIST_UTILITY_TESTS
 
 TEST(ArrayListUtilityTests, BasicBubblesortTest)
@@ -88,9 +96,9 @@ TEST(ArrayListUtilityTests, AlreadySortedTest)
 
 TEST(ArrayListUtilityTests, Shuffle)
 {
-	// Shuffle is a bit hard to test since it's random.  We shouldn't, however
-	// have any items that are in there original spots if we have a list of
-	// at least size 2
+	// Shuffle is a bit hard to test since it's random.  A uniformly random permutation leaves
+	// each item in its original spot with probability 1/num, so we expect about one item (and
+	// practically never more than a handful) to stay put -- not zero.  Every item must still be there.
 	ssuds::ArrayList<int> s;
 	const int num = 1000;
 	for (int i = 0; i < num; i++)
@@ -99,8 +107,150 @@ TEST(ArrayListUtilityTests, Shuffle)
 	ssuds::shuffle(s);
 	ASSERT_EQ(s.size(), num);
 
+	int num_fixed = 0;
+	ssuds::ArrayList<bool> seen;
+	for (int i = 0; i < num; i++)
+		seen.append(false);
+	for (int i = 0; i < num; i++)
+	{
+		if (s[i] == i)
+			num_fixed++;
+		ASSERT_FALSE(seen[s[i]]);
+		seen[s[i]] = true;
+	}
+	EXPECT_LT(num_fixed, 10);
+
+	// Unseeded shuffles differ from call to call
+	ssuds::ArrayList<int> t(s);
+	ssuds::shuffle(t);
+	bool same = true;
+	for (int i = 0; i < num; i++)
+		same = same && s[i] == t[i];
+	EXPECT_FALSE(same);
+}
+
+
+TEST(ArrayListUtilityTests, SeededShuffle)
+{
+	ssuds::ArrayList<int> a, b, c;
+	for (int i = 0; i < 500; i++)
+	{
+		a.append(i);
+		b.append(i);
+		c.append(i);
+	}
+	ssuds::shuffle(a, 1234ull);
+	ssuds::shuffle(b, 1234ull);
+	ssuds::shuffle(c, 4321ull);
+	bool same_as_c = true;
+	for (int i = 0; i < 500; i++)
+	{
+		EXPECT_EQ(a[i], b[i]);
+		same_as_c = same_as_c && a[i] == c[i];
+	}
+	EXPECT_FALSE(same_as_c);
+
+	// Any engine works, and the same engine state gives the same permutation
+	std::mt19937 gen1(5), gen2(5);
+	ssuds::shuffle(a, gen1);
+	ssuds::shuffle(b, gen2);
+	for (int i = 0; i < 500; i++)
+		EXPECT_EQ(a[i], b[i]);
+	ssuds::Xoshiro256 engine(9);
+	ssuds::shuffle(a, engine);
+
+	// Each of the 6 orders of 3 values should come up about equally often
+	int order_counts[6] = {};
+	ssuds::Xoshiro256 counting_engine(77);
+	for (int trial = 0; trial < 60000; trial++)
+	{
+		ssuds::ArrayList<int> small = { 0, 1, 2 };
+		ssuds::shuffle(small, counting_engine);
+		order_counts[small[0] * 2 + (small[1] > small[2] ? 1 : 0)]++;
+	}
+	for (int k = 0; k < 6; k++)
+	{
+		EXPECT_GT(order_counts[k], 9500);
+		EXPECT_LT(order_counts[k], 10500);
+	}
+}
+
+
+TEST(ArrayListUtilityTests, UniformBelow)
+{
+	ssuds::Xoshiro256 engine(3);
+	int counts[7] = {};
+	for (int i = 0; i < 70000; i++)
+	{
+		std::uint32_t r = ssuds::uniform_below(engine, 7);
+		ASSERT_LT(r, 7u);
+		counts[r]++;
+	}
+	for (int k = 0; k < 7; k++)
+	{
+		EXPECT_GT(counts[k], 9500);
+		EXPECT_LT(counts[k], 10500);
+	}
+	EXPECT_EQ(ssuds::uniform_below(engine, 1), 0u);
+
+	// Engines with other ranges go through a std distribution
+	std::minstd_rand small_range(1);
+	for (int i = 0; i < 1000; i++)
+		ASSERT_LT(ssuds::uniform_below(small_range, 1000000), 1000000u);
+
+	ssuds::Xoshiro256 a(42), b(42), c(42, 1);
+	for (int i = 0; i < 10; i++)
+	{
+		std::uint64_t value = a();
+		EXPECT_EQ(value, b());
+		EXPECT_NE(value, c());
+	}
+}
+
+
+TEST(ArrayListUtilityTests, ParallelShuffle)
+{
+	const int num = 300000;
+	ssuds::ArrayList<int> a, b;
+	for (int i = 0; i < num; i++)
+	{
+		a.append(i);
+		b.append(i);
+	}
+
+	// The permutation only depends on the seed, not on the number of threads
+	ssuds::parallel_shuffle(a, 99, 4);
+	ssuds::ThreadPool pool(2);
+	ssuds::parallel_shuffle(b, 99, pool);
+	int num_fixed = 0;
+	ssuds::ArrayList<bool> seen;
+	for (int i = 0; i < num; i++)
+		seen.append(false);
+	for (int i = 0; i < num; i++)
+	{
+		ASSERT_EQ(a[i], b[i]);
+		ASSERT_FALSE(seen[a[i]]);
+		seen[a[i]] = true;
+		if (a[i] == i)
+			num_fixed++;
+	}
+	EXPECT_LT(num_fixed, 10);
+
+	// Values should move all over the list, not just within their block
+	long long far_moves = 0;
 	for (int i = 0; i < num; i++)
-		EXPECT_NE(s[i], i);
+	{
+		if (std::abs(a[i] - i) > num / 4)
+			far_moves++;
+	}
+	EXPECT_GT(far_moves, num / 2);
+
+	ssuds::ArrayList<std::string> small = { "a", "b", "c", "d" };
+	ssuds::ArrayList<std::string> small2(small);
+	ssuds::parallel_shuffle(small, 5);
+	ssuds::parallel_shuffle(small2, 5, 3);
+	for (int i = 0; i < 4; i++)
+		EXPECT_EQ(small[i], small2[i]);
 }
 
 
@@ -183,4 +333,336 @@ TEST(ArrayListUtilityTests, BinarySearch)
 }
 
 
+TEST(ArrayListUtilityTests, QuicksortPatterns)
+{
+	// The inputs that hurt a naive quicksort: sorted, reversed, all-equal, few distinct values, organ-pipe,
+	// and a sawtooth.  Every one should come out the same as std::sort
+	const int num = 20000;
+	for (int pattern = 0; pattern < 7; pattern++)
+	{
+		ssuds::ArrayList<int> s;
+		std::mt19937 gen(pattern);
+		for (int i = 0; i < num; i++)
+		{
+			switch (pattern)
+			{
+			case 0: s.append(i); break;
+			case 1: s.append(num - i); break;
+			case 2: s.append(7); break;
+			case 3: s.append((int)(gen() % 4)); break;
+			case 4: s.append(i < num / 2 ? i : num - i); break;
+			case 5: s.append(i % 100); break;
+			default: s.append((int)gen()); break;
+			}
+		}
+		ssuds::ArrayList<int> expected(s);
+		std::sort(expected.begin(), expected.end());
+		ssuds::ArrayList<int> t(s);
+
+		ssuds::quicksort(s, ssuds::SortOrder::ASCENDING);
+		ssuds::quicksort(t, ssuds::SortOrder::DESCENDING);
+		for (int i = 0; i < num; i++)
+		{
+			ASSERT_EQ(s[i], expected[i]) << "pattern " << pattern;
+			ASSERT_EQ(t[i], expected[num - 1 - i]) << "pattern " << pattern;
+		}
+	}
+}
+
+
+TEST(ArrayListUtilityTests, QuicksortLinearOnEasyInputs)
+{
+	// Sorted and all-equal inputs are detected, so they take about one move per value
+	const int num = 100000;
+	ssuds::ArrayList<int> sorted, equal;
+	for (int i = 0; i < num; i++)
+	{
+		sorted.append(i);
+		equal.append(3);
+	}
+	EXPECT_LT(ssuds::quicksort(sorted, ssuds::SortOrder::ASCENDING), (unsigned long)num);
+	EXPECT_LT(ssuds::quicksort(equal, ssuds::SortOrder::ASCENDING), (unsigned long)num);
+	for (int i = 0; i < num; i++)
+		ASSERT_EQ(sorted[i], i);
+}
+
+
+TEST(ArrayListUtilityTests, QuicksortComparatorsAndCounters)
+{
+	ssuds::ArrayList<std::string> s = { "pear", "fig", "banana", "kiwi", "apple", "plum", "cherry", "date" };
+	ssuds::quicksort(s, ssuds::SortAscending());
+	EXPECT_EQ(s[0], "apple");
+	EXPECT_EQ(s[7], "plum");
+
+	// Any comparator works, e.g. a lambda.  Sort by length, then alphabetically
+	ssuds::OpCounter counter;
+	ssuds::quicksort(s, [](const std::string& a, const std::string& b)
+	{
+		return a.size() != b.size() ? a.size() < b.size() : a < b;
+	}, counter);
+	const char* by_length[] = { "fig", "date", "kiwi", "pear", "plum", "apple", "banana", "cherry" };
+	for (int i = 0; i < 8; i++)
+		EXPECT_EQ(s[i], by_length[i]);
+	EXPECT_GT(counter.total(), 0u);
+
+	ssuds::NullOpCounter no_counter;
+	ssuds::quicksort(s, ssuds::SortDescending(), no_counter);
+	EXPECT_EQ(no_counter.total(), 0u);
+	EXPECT_EQ(s[0], "plum");
+	EXPECT_EQ(s[7], "apple");
+
+	ssuds::ArrayList<int> empty;
+	EXPECT_EQ(ssuds::quicksort(empty, ssuds::SortOrder::ASCENDING), 0u);
+	ssuds::ArrayList<int> one = { 5 };
+	ssuds::quicksort(one, ssuds::SortOrder::DESCENDING);
+	EXPECT_EQ(one[0], 5);
+}
+
+
+TEST(ArrayListUtilityTests, ParallelSort)
+{
+	const int num = 500000;
+	ssuds::ThreadPool pool(4);
+	for (int pattern = 0; pattern < 4; pattern++)
+	{
+		ssuds::ArrayList<int> s;
+		std::mt19937 gen(pattern);
+		for (int i = 0; i < num; i++)
+		{
+			switch (pattern)
+			{
+			case 0: s.append((int)gen()); break;
+			case 1: s.append((int)(gen() % 3)); break;
+			case 2: s.append(num - i); break;
+			default: s.append(i % 2 == 0 ? 5 : (int)(gen() % 1000)); break;
+			}
+		}
+		ssuds::ArrayList<int> expected(s);
+		std::sort(expected.begin(), expected.end());
+
+		ssuds::parallel_sort(s, ssuds::SortAscending(), pool);
+		ASSERT_EQ(s.size(), num);
+		for (int i = 0; i < num; i++)
+			ASSERT_EQ(s[i], expected[i]) << "pattern " << pattern;
+	}
+}
+
+
+TEST(ArrayListUtilityTests, ParallelSortStringsAndSmallLists)
+{
+	ssuds::ArrayList<std::string> s;
+	std::mt19937 gen(7);
+	for (int i = 0; i < 100000; i++)
+		s.append(std::to_string(gen() % 20000));
+	ssuds::ArrayList<std::string> expected(s);
+	std::sort(expected.begin(), expected.end(), std::greater<std::string>());
+	ssuds::parallel_sort(s, ssuds::SortDescending(), 3);
+	ASSERT_EQ(s.size(), expected.size());
+	for (unsigned int i = 0; i < s.size(); i++)
+		ASSERT_EQ(s[i], expected[i]);
+
+	// Below the cutoff this is just quicksort
+	ssuds::ArrayList<int> small = { 4, 1, 3, 2 };
+	ssuds::parallel_sort(small, ssuds::SortAscending());
+	for (int i = 0; i < 4; i++)
+		EXPECT_EQ(small[i], i + 1);
+	ssuds::ArrayList<int> empty;
+	ssuds::parallel_sort(empty, ssuds::SortAscending(), 4);
+	EXPECT_EQ(empty.size(), 0);
+}
+
+
+/// Compares strings, but throws once a shared call counter reaches a limit
+struct ThrowingStringCompare
+{
+	std::atomic<long>* mCalls;
+	long mLimit;
+
+	bool operator()(const std::string& a, const std::string& b) const
+	{
+		if (++*mCalls == mLimit)
+			throw std::runtime_error("comparison failed");
+		return a < b;
+	}
+};
+
+
+TEST(ArrayListUtilityTests, ParallelSortKeepsValuesIfCompareThrows)
+{
+	// Throw at different points: while classifying, and while sorting the buckets
+	const int num = 1 << 17;
+	ssuds::ThreadPool pool(4);
+	ssuds::ArrayList<std::string> original;
+	std::mt19937 gen(11);
+	for (int i = 0; i < num; i++)
+		original.append(std::to_string(gen() % 1000000));
+	ssuds::ArrayList<std::string> expected(original);
+	std::sort(expected.begin(), expected.end());
+
+	for (long limit : { (long)num / 2, 3L * num, 8L * num, 14L * num })
+	{
+		ssuds::ArrayList<std::string> s(original);
+		std::atomic<long> calls(0);
+		EXPECT_THROW(ssuds::parallel_sort(s, ThrowingStringCompare{ &calls, limit }, pool), std::runtime_error) << "limit " << limit;
+		std::sort(s.begin(), s.end());
+		ASSERT_EQ(s.size(), expected.size());
+		for (unsigned int i = 0; i < s.size(); i++)
+			ASSERT_EQ(s[i], expected[i]) << "limit " << limit;
+	}
+}
+
+
+/// A string wrapper with no default constructor
+struct NamedValue
+{
+	std::string mName;
+
+	explicit NamedValue(const std::string& name) : mName(name) {}
+
+	bool operator<(const NamedValue& other) const
+	{
+		return mName < other.mName;
+	}
+};
+
+
+TEST(ArrayListUtilityTests, ParallelSortWithoutDefaultConstructor)
+{
+	const int num = 100000;
+	ssuds::ArrayList<NamedValue> s;
+	std::mt19937 gen(13);
+	for (int i = 0; i < num; i++)
+		s.append(NamedValue(std::to_string(gen() % 50000)));
+	ssuds::ArrayList<std::string> expected;
+	for (int i = 0; i < num; i++)
+		expected.append(s[i].mName);
+	std::sort(expected.begin(), expected.end());
+
+	ssuds::parallel_shuffle(s, 3, 4);
+	ssuds::parallel_sort(s, ssuds::SortAscending(), 4);
+	ASSERT_EQ(s.size(), num);
+	for (int i = 0; i < num; i++)
+		ASSERT_EQ(s[i].mName, expected[i]);
+}
+
+
+TEST(ArrayListUtilityTests, RadixSortNumbers)
+{
+	const int num = 50000;
+	std::mt19937 gen(3);
+	ssuds::ArrayList<int> ints;
+	ssuds::ArrayList<unsigned int> small_ids;
+	ssuds::ArrayList<float> floats;
+	ssuds::ArrayList<long long> longs;
+	for (int i = 0; i < num; i++)
+	{
+		ints.append((int)gen());
+		small_ids.append(gen() % 1000);
+		floats.append(std::uniform_real_distribution<float>(-1000.0f, 1000.0f)(gen));
+		longs.append(((long long)gen() << 32) | gen());
+	}
+	floats[0] = 0.0f;
+	floats[1] = -0.5f;
+	floats[2] = std::numeric_limits<float>::infinity();
+	floats[3] = -std::numeric_limits<float>::infinity();
+
+	ssuds::ArrayList<int> expected_ints(ints);
+	std::sort(expected_ints.begin(), expected_ints.end());
+	ssuds::ArrayList<unsigned int> expected_ids(small_ids);
+	std::sort(expected_ids.begin(), expected_ids.end(), std::greater<unsigned int>());
+	ssuds::ArrayList<float> expected_floats(floats);
+	std::sort(expected_floats.begin(), expected_floats.end());
+	ssuds::ArrayList<long long> expected_longs(longs);
+	std::sort(expected_longs.begin(), expected_longs.end());
+
+	ssuds::radix_sort(ints);
+	ssuds::radix_sort(small_ids, ssuds::SortOrder::DESCENDING);
+	ssuds::radix_sort(floats, ssuds::SortOrder::ASCENDING);
+	ssuds::radix_sort(longs);
+	for (int i = 0; i < num; i++)
+	{
+		ASSERT_EQ(ints[i], expected_ints[i]);
+		ASSERT_EQ(small_ids[i], expected_ids[i]);
+		ASSERT_EQ(floats[i], expected_floats[i]);
+		ASSERT_EQ(longs[i], expected_longs[i]);
+	}
+
+	ssuds::ArrayList<short> tiny = { 3, -1, 2 };
+	ssuds::radix_sort(tiny, ssuds::SortOrder::DESCENDING);
+	EXPECT_EQ(tiny[0], 3);
+	EXPECT_EQ(tiny[2], -1);
+	ssuds::ArrayList<int> empty;
+	ssuds::radix_sort(empty);
+	EXPECT_EQ(empty.size(), 0);
+}
+
+
+TEST(ArrayListUtilityTests, RadixSortByKeyIsStable)
+{
+	// Sort "edges" by source node, like packing them into CSR order.  Edges with the same source must stay
+	// in their original order
+	struct Edge
+	{
+		int source;
+		std::string label;
+	};
+	ssuds::ArrayList<Edge> edges;
+	std::mt19937 gen(11);
+	for (int i = 0; i < 2000; i++)
+		edges.append(Edge{ (int)(gen() % 50) - 25, std::to_string(i) });
+
+	ssuds::radix_sort(edges, [](const Edge& e) { return e.source; });
+	for (unsigned int i = 1; i < edges.size(); i++)
+	{
+		ASSERT_LE(edges[i - 1].source, edges[i].source);
+		if (edges[i - 1].source == edges[i].source)
+		{
+			ASSERT_LT(std::stoi(edges[i - 1].label), std::stoi(edges[i].label));
+		}
+	}
+
+	ssuds::radix_sort(edges, [](const Edge& e) { return (float)e.source * 0.5f; }, ssuds::SortOrder::DESCENDING);
+	for (unsigned int i = 1; i < edges.size(); i++)
+	{
+		ASSERT_GE(edges[i - 1].source, edges[i].source);
+		if (edges[i - 1].source == edges[i].source)
+		{
+			ASSERT_LT(std::stoi(edges[i - 1].label), std::stoi(edges[i].label));
+		}
+	}
+}
+
+
+TEST(ArrayListUtilityTests, FindLowerBound)
+{
+	// Even values 0, 2, ..., with every multiple of 10 repeated
+	ssuds::ArrayList<int> s;
+	for (int i = 0; i < 1000; i += 2)
+	{
+		s.append(i);
+		if (i % 10 == 0)
+			s.append(i);
+	}
+	ssuds::ArrayList<int> t(s);
+	std::reverse(t.begin(), t.end());
+
+	unsigned long op_count;
+	for (int v = -1; v <= 1000; v++)
+	{
+		unsigned int expected = (unsigned int)(std::lower_bound(s.begin(), s.end(), v) - s.begin());
+		EXPECT_EQ(ssuds::find_lower_bound(s, ssuds::SortOrder::ASCENDING, v, &op_count), expected);
+		EXPECT_LE(op_count, 11u);
+		expected = (unsigned int)(std::lower_bound(t.begin(), t.end(), v, std::greater<int>()) - t.begin());
+		EXPECT_EQ(ssuds::find_lower_bound(t, ssuds::SortOrder::DESCENDING, v), expected);
+	}
+
+	// find_binary_search gives the first of a run of duplicates
+	EXPECT_EQ(ssuds::find_binary_search(s, ssuds::SortOrder::ASCENDING, 10), 6);
+	EXPECT_EQ(ssuds::find_binary_search(s, ssuds::SortOrder::ASCENDING, 11), -1);
+	ssuds::ArrayList<int> empty;
+	EXPECT_EQ(ssuds::find_lower_bound(empty, ssuds::SortOrder::ASCENDING, 3), 0u);
+	EXPECT_EQ(ssuds::find_binary_search(empty, ssuds::SortOrder::ASCENDING, 3), -1);
+}
+
+
 #endif
\ No newline at end of file
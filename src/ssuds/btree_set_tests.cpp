@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <btree_set.h>
+#include <random>
+#include <set>
+#include <string>
+
+#define DO_BTREE_SET_TESTS 1
+#if DO_BTREE_SET_TESTS
+
+TEST(BTreeSetTests, BasicOperations)
+{
+	ssuds::BTreeSet<std::string> s{ "Doug", "Abe", "Bob", "Carl", "Erin", "Eric", "Abe" };
+	EXPECT_EQ(s.size(), 6);
+	EXPECT_TRUE(s.contains("Carl"));
+	EXPECT_FALSE(s.contains("carl"));
+	EXPECT_FALSE(s.insert("Bob"));
+	EXPECT_TRUE(s.insert("Dan"));
+	EXPECT_TRUE(s.erase("Abe"));
+	EXPECT_FALSE(s.erase("Abe"));
+	EXPECT_EQ(s.size(), 6);
+
+	const char* in_order[] = { "Bob", "Carl", "Dan", "Doug", "Eric", "Erin" };
+	int i = 0;
+	for (const std::string& name : s)
+		EXPECT_EQ(name, in_order[i++]);
+	EXPECT_EQ(i, 6);
+
+	ssuds::BTreeSet<std::string> copy(s);
+	s.clear();
+	EXPECT_EQ(s.size(), 0);
+	EXPECT_FALSE(s.begin() != s.end());
+	EXPECT_EQ(copy.size(), 6);
+	EXPECT_TRUE(copy.contains("Erin"));
+	s = copy;
+	EXPECT_TRUE(s.contains("Dan"));
+	ssuds::BTreeSet<std::string> moved(std::move(copy));
+	EXPECT_EQ(moved.size(), 6);
+	EXPECT_EQ(copy.size(), 0);
+}
+
+
+TEST(BTreeSetTests, MatchesStdSet)
+{
+	// Tiny nodes (3 values) make a deep tree, so every split / borrow / merge case gets exercised
+	ssuds::BTreeSet<int, 12> small_nodes;
+	ssuds::BTreeSet<unsigned int> big_nodes;
+	std::set<int> reference;
+	EXPECT_EQ(small_nodes.node_capacity(), 3u);
+	std::mt19937 gen(17);
+	for (int step = 0; step < 100000; step++)
+	{
+		int val = (int)(gen() % 3000) - 1000;
+		if (gen() % 3 != 0)
+		{
+			bool added = reference.insert(val).second;
+			ASSERT_EQ(small_nodes.insert(val), added);
+			ASSERT_EQ(big_nodes.insert((unsigned int)val), added);
+		}
+		else
+		{
+			bool removed = reference.erase(val) > 0;
+			ASSERT_EQ(small_nodes.erase(val), removed);
+			ASSERT_EQ(big_nodes.erase((unsigned int)val), removed);
+		}
+		ASSERT_EQ(small_nodes.size(), reference.size());
+		if (step % 997 == 0)
+		{
+			std::set<int>::iterator it = reference.begin();
+			for (int v : small_nodes)
+			{
+				ASSERT_EQ(v, *it);
+				++it;
+			}
+			ASSERT_TRUE(it == reference.end());
+			for (int probe = -1001; probe < 2001; probe += 7)
+			{
+				ASSERT_EQ(small_nodes.contains(probe), reference.count(probe) > 0);
+				ASSERT_EQ(big_nodes.contains((unsigned int)probe), reference.count(probe) > 0);
+			}
+		}
+	}
+
+	// Empty it completely
+	for (int v : reference)
+		EXPECT_TRUE(small_nodes.erase(v));
+	EXPECT_EQ(small_nodes.size(), 0);
+	EXPECT_EQ(small_nodes.get_height(), 0);
+}
+
+
+TEST(BTreeSetTests, ShallowForSortedInserts)
+{
+	const unsigned int num = 1000000;
+	ssuds::BTreeSet<unsigned int> s;
+	for (unsigned int i = 0; i < num; i++)
+		s.insert(i);
+	EXPECT_EQ(s.size(), num);
+
+	// With at least 30 values per node, a million values fit in 5 levels
+	EXPECT_LE(s.get_height(), 5);
+	for (unsigned int i = 0; i < num; i += 101)
+		EXPECT_TRUE(s.contains(i));
+	EXPECT_FALSE(s.contains(num));
+
+	unsigned int expected = 0;
+	for (unsigned int v : s)
+		ASSERT_EQ(v, expected++);
+	EXPECT_EQ(expected, num);
+}
+
+#endif
@@ -0,0 +1,112 @@
+#define DO_CSR_GRAPH_TESTS 1
+#if DO_CSR_GRAPH_TESTS
+
+#include <gtest/gtest.h>
+#include <graph.h>
+
+class CsrGraphTests : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        for (char c : {'a', 'b', 'c', 'd', 'e', 'f'})
+            int_graph.add_node(c);
+        int_graph.set_edge('a', 'b', 15);
+        int_graph.set_edge('d', 'e', 18);
+        int_graph.set_edge('a', 'c', 32);
+        int_graph.set_edge('c', 'a', 33);
+        int_graph.set_edge('c', 'd', 7);
+    }
+
+    ssuds::Graph<char, int> int_graph;
+};
+
+
+TEST_F(CsrGraphTests, Freeze)
+{
+    ssuds::CsrGraph<char, int> csr = int_graph.freeze();
+    EXPECT_EQ(csr.num_nodes(), 6);
+    EXPECT_EQ(csr.num_edges(), 5);
+    EXPECT_EQ(csr.index_of('x'), -1);
+
+    // Every node should map back and forth, and every edge should match the original graph
+    unsigned int total_edges = 0;
+    for (char c : {'a', 'b', 'c', 'd', 'e', 'f'})
+    {
+        int index = csr.index_of(c);
+        ASSERT_GE(index, 0);
+        EXPECT_EQ(csr.node_at(index), c);
+        EXPECT_EQ(csr.edge_end(index) - csr.edge_begin(index), csr.degree(index));
+        for (unsigned int e = csr.edge_begin(index); e < csr.edge_end(index); e++)
+        {
+            char dest = csr.node_at(csr.target(e));
+            ASSERT_TRUE(int_graph.contains_edge(c, dest));
+            EXPECT_EQ(csr.weight(e), int_graph.get_edge(c, dest));
+            total_edges++;
+        }
+    }
+    EXPECT_EQ(total_edges, 5);
+    EXPECT_EQ(csr.degree(csr.index_of('a')), 2);
+    EXPECT_EQ(csr.degree(csr.index_of('b')), 0);
+
+    // The snapshot is independent of later changes
+    int_graph.remove_node('a');
+    EXPECT_EQ(csr.num_nodes(), 6);
+    EXPECT_GE(csr.index_of('a'), 0);
+}
+
+
+TEST_F(CsrGraphTests, EmptyGraph)
+{
+    ssuds::Graph<char, int> empty_graph;
+    ssuds::CsrGraph<char, int> csr = empty_graph.freeze();
+    EXPECT_EQ(csr.num_nodes(), 0);
+    EXPECT_EQ(csr.num_edges(), 0);
+}
+
+
+TEST_F(CsrGraphTests, Traversals)
+{
+    ssuds::CsrGraph<char, int> csr = int_graph.freeze();
+    int a = csr.index_of('a');
+    ssuds::ArrayList<int> bfs = csr.breadth_first(a);
+    ssuds::ArrayList<int> dfs = csr.depth_first(a);
+    ASSERT_EQ(bfs.size(), 6);
+    ASSERT_EQ(dfs.size(), 6);
+
+    EXPECT_EQ(bfs[a], a);
+    EXPECT_EQ(bfs[csr.index_of('b')], a);
+    EXPECT_EQ(bfs[csr.index_of('c')], a);
+    EXPECT_EQ(bfs[csr.index_of('d')], csr.index_of('c'));
+    EXPECT_EQ(bfs[csr.index_of('e')], csr.index_of('d'));
+    EXPECT_EQ(bfs[csr.index_of('f')], -1);
+
+    // The depth-first tree has the same reachable set (the exact parents depend on edge order)
+    for (char c : {'a', 'b', 'c', 'd', 'e'})
+        EXPECT_NE(dfs[csr.index_of(c)], -1);
+    EXPECT_EQ(dfs[csr.index_of('f')], -1);
+    EXPECT_EQ(dfs[csr.index_of('e')], csr.index_of('d'));
+}
+
+
+TEST_F(CsrGraphTests, LongPath)
+{
+    // A long path would overflow the call stack of a recursive traversal
+    ssuds::Graph<int, float> path;
+    const int num = 20000;
+    for (int i = 0; i < num; i++)
+        path.add_node(i);
+    for (int i = 0; i < num - 1; i++)
+        path.set_edge(i, i + 1, 1.0f);
+
+    ssuds::CsrGraph<int, float> csr = path.freeze();
+    ssuds::ArrayList<int> bfs = csr.breadth_first(csr.index_of(0));
+    ssuds::ArrayList<int> dfs = csr.depth_first(csr.index_of(0));
+    for (int i = 1; i < num; i++)
+    {
+        EXPECT_EQ(csr.node_at(bfs[csr.index_of(i)]), i - 1);
+        EXPECT_EQ(csr.node_at(dfs[csr.index_of(i)]), i - 1);
+    }
+}
+
+#endif
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <eytzinger_index.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+
+#define DO_EYTZINGER_INDEX_TESTS 1
+#if DO_EYTZINGER_INDEX_TESTS
+
+TEST(EytzingerIndexTests, MatchesBinarySearch)
+{
+	// Try every size around a few powers of two (where the tree's last level is nearly empty / full)
+	for (unsigned int size = 0; size < 70; size++)
+	{
+		ssuds::ArrayList<int> s;
+		for (unsigned int i = 0; i < size; i++)
+			s.append(3 * (int)i);
+		ssuds::EytzingerIndex<int> index(s);
+		ASSERT_EQ(index.size(), size);
+		for (int v = -2; v <= 3 * (int)size + 1; v++)
+		{
+			unsigned int expected = (unsigned int)(std::lower_bound(s.begin(), s.end(), v) - s.begin());
+			ASSERT_EQ(index.lower_bound(v), expected) << "size " << size << ", value " << v;
+			ASSERT_EQ(index.find(v), v % 3 == 0 && expected < size ? (int)expected : -1);
+			ASSERT_EQ(index.contains(v), index.find(v) >= 0);
+		}
+	}
+}
+
+
+TEST(EytzingerIndexTests, DuplicatesDescendingAndOps)
+{
+	ssuds::ArrayList<std::string> s = { "kiwi", "fig", "fig", "fig", "date", "banana", "apple" };
+	ssuds::EytzingerIndex<std::string, ssuds::SortDescending> index(s);
+	EXPECT_EQ(index.find("fig"), 1);
+	EXPECT_EQ(index.find("apple"), 6);
+	EXPECT_EQ(index.find("cherry"), -1);
+	EXPECT_EQ(index.lower_bound("cherry"), 5u);
+	EXPECT_EQ(index.lower_bound("lemon"), 0u);
+	EXPECT_EQ(index.lower_bound("a"), 7u);
+
+	// A search always goes all the way down the tree: floor(log2(n)) + 1 comparisons
+	ssuds::ArrayList<unsigned int> ids;
+	for (unsigned int i = 0; i < 100000; i++)
+		ids.append(i * 7);
+	ssuds::EytzingerIndex<unsigned int> id_index(ids);
+	unsigned long num_ops = 0;
+	EXPECT_EQ(id_index.find(7 * 12345, &num_ops), 12345);
+	EXPECT_GE(num_ops, 16u);
+	EXPECT_LE(num_ops, 17u);
+	EXPECT_EQ(id_index.find(7 * 12345 + 1, &num_ops), -1);
+}
+
+
+/// A record with no default constructor and no operator==, ordered only by its id
+struct IdRecord
+{
+	int mId;
+	std::string mLabel;
+
+	IdRecord(int id, const std::string& label) : mId(id), mLabel(label) {}
+};
+
+struct CompareById
+{
+	bool operator()(const IdRecord& a, const IdRecord& b) const
+	{
+		return a.mId < b.mId;
+	}
+};
+
+
+TEST(EytzingerIndexTests, CustomComparatorWithoutDefaultConstructor)
+{
+	ssuds::ArrayList<IdRecord> s;
+	for (int i = 0; i < 20; i++)
+		s.append(IdRecord(2 * i, "record " + std::to_string(i)));
+	ssuds::EytzingerIndex<IdRecord, CompareById> index(s);
+	ASSERT_EQ(index.size(), 20u);
+
+	// Values are found by equivalence under the comparator, whatever their other members hold
+	EXPECT_EQ(index.find(IdRecord(14, "")), 7);
+	EXPECT_TRUE(index.contains(IdRecord(38, "something else")));
+	EXPECT_EQ(index.find(IdRecord(15, "record 7")), -1);
+	EXPECT_EQ(index.lower_bound(IdRecord(15, "")), 8u);
+	EXPECT_EQ(index.lower_bound(IdRecord(39, "")), 20u);
+
+	ssuds::ArrayList<IdRecord> empty;
+	ssuds::EytzingerIndex<IdRecord, CompareById> empty_index(empty);
+	EXPECT_EQ(empty_index.size(), 0u);
+	EXPECT_EQ(empty_index.find(IdRecord(0, "")), -1);
+	EXPECT_EQ(empty_index.lower_bound(IdRecord(0, "")), 0u);
+}
+
+#endif
@@ -0,0 +1,138 @@
+#define DO_GRAPH_BFS_TESTS 1
+#if DO_GRAPH_BFS_TESTS
+
+#include <gtest/gtest.h>
+#include <graph_bfs.h>
+
+class GraphBfsTests : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // A random, low-diameter directed graph (plus a few nodes that can't be reached)
+        for (int i = 0; i < num_nodes; i++)
+            graph.add_node(i * 3);
+        unsigned int state = 99;
+        for (int i = 0; i < num_nodes * 12; i++)
+        {
+            state = state * 1664525u + 1013904223u;
+            int a = (state >> 4) % (num_nodes - 10);
+            state = state * 1664525u + 1013904223u;
+            int b = (state >> 4) % (num_nodes - 10);
+            graph.set_edge(a * 3, b * 3, 1.0f);
+        }
+    }
+
+    /// Computes the expected (canonical) parents: the lowest-indexed node one level closer to the start
+    ssuds::ArrayList<int> expected_parents(const ssuds::CsrGraph<int, float>& csr, unsigned int start)
+    {
+        ssuds::ArrayList<int> tree = csr.breadth_first(start);
+        ssuds::ArrayList<int> levels;
+        for (unsigned int i = 0; i < csr.num_nodes(); i++)
+            levels.append(-1);
+        levels[start] = 0;
+        // Walk each node's tree path to find its level
+        for (unsigned int i = 0; i < csr.num_nodes(); i++)
+        {
+            if (tree[i] < 0)
+                continue;
+            int depth = 0;
+            unsigned int cur = i;
+            while (cur != start)
+            {
+                cur = tree[cur];
+                depth++;
+            }
+            levels[i] = depth;
+        }
+
+        ssuds::ArrayList<int> result;
+        for (unsigned int i = 0; i < csr.num_nodes(); i++)
+            result.append(i == start ? (int)start : -1);
+        for (unsigned int u = 0; u < csr.num_nodes(); u++)
+        {
+            for (unsigned int e = csr.edge_begin(u); e < csr.edge_end(u); e++)
+            {
+                unsigned int v = csr.target(e);
+                if (v != start && levels[u] >= 0 && levels[v] == levels[u] + 1 && (result[v] < 0 || (int)u < result[v]))
+                    result[v] = u;
+            }
+        }
+        return result;
+    }
+
+    const int num_nodes = 3000;
+    ssuds::Graph<int, float> graph;
+};
+
+
+TEST_F(GraphBfsTests, MatchesReference)
+{
+    ssuds::BreadthFirstSearch<int, float> bfs(graph);
+    const ssuds::CsrGraph<int, float>& csr = bfs.graph();
+    unsigned int start = csr.index_of(0);
+    ssuds::ArrayList<int> expected = expected_parents(csr, start);
+
+    // Default heuristics, top-down only, and bottom-up as early as possible should all agree
+    double settings[3][2] = { {14.0, 24.0}, {0.0, 24.0}, {1e9, 1e9} };
+    for (int s = 0; s < 3; s++)
+    {
+        bfs.set_heuristics(settings[s][0], settings[s][1]);
+        unsigned int reached = bfs.run(0);
+        unsigned int expected_reached = 0;
+        for (unsigned int i = 0; i < csr.num_nodes(); i++)
+        {
+            EXPECT_EQ(bfs.parent(i), expected[i]);
+            EXPECT_EQ(bfs.reached(i), expected[i] >= 0);
+            if (expected[i] >= 0)
+            {
+                expected_reached++;
+                if (i != start)
+                {
+                    EXPECT_EQ(bfs.level(i), bfs.level(expected[i]) + 1);
+                }
+            }
+        }
+        EXPECT_EQ(reached, expected_reached);
+        if (s == 1)
+        {
+            EXPECT_EQ(bfs.num_bottom_up_steps(), 0);
+        }
+        else
+        {
+            EXPECT_GT(bfs.num_bottom_up_steps(), 0);
+        }
+    }
+
+    // The last 10 nodes have no edges at all
+    EXPECT_FALSE(bfs.reached(csr.index_of((num_nodes - 1) * 3)));
+    EXPECT_EQ(bfs.level(start), 0);
+    EXPECT_EQ(bfs.parent(start), (int)start);
+}
+
+
+TEST_F(GraphBfsTests, ParentMapAndErrors)
+{
+    ssuds::Graph<char, int> small;
+    for (char c : {'a', 'b', 'c', 'd'})
+        small.add_node(c);
+    small.set_edge('a', 'b', 1);
+    small.set_edge('b', 'c', 1);
+    small.set_edge('d', 'a', 1);
+
+    ssuds::BreadthFirstSearch<char, int> bfs(small);
+    EXPECT_THROW(bfs.run('x'), std::out_of_range);
+    EXPECT_EQ(bfs.run('a'), 3);
+    ssuds::UnorderedMap<char, char> parents = bfs.parent_map();
+    EXPECT_EQ(parents.size(), 3);
+    EXPECT_EQ((*parents.find('a')).second, 'a');
+    EXPECT_EQ((*parents.find('b')).second, 'a');
+    EXPECT_EQ((*parents.find('c')).second, 'b');
+    EXPECT_EQ(parents.find('d'), parents.end());
+
+    // The engine can be re-used
+    EXPECT_EQ(bfs.run('d'), 4);
+    EXPECT_EQ(bfs.level(bfs.graph().index_of('c')), 3);
+}
+
+#endif
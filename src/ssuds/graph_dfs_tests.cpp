@@ -0,0 +1,166 @@
+#define DO_GRAPH_DFS_TESTS 1
+#define DO_GRAPH_DFS_HUGE_TESTS 0
+#if DO_GRAPH_DFS_TESTS
+
+#include <gtest/gtest.h>
+#include <graph_dfs.h>
+
+class GraphDfsTests : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        //   10 -> 20 -> 40
+        //    |     |
+        //    v     v
+        //   30 -> 50     60 -> 70 (not reachable from 10)
+        for (int n : { 10, 20, 30, 40, 50, 60, 70 })
+            graph.add_node(n);
+        graph.set_edge(10, 20, 1.0f);
+        graph.set_edge(10, 30, 1.0f);
+        graph.set_edge(20, 40, 1.0f);
+        graph.set_edge(20, 50, 1.0f);
+        graph.set_edge(30, 50, 1.0f);
+        graph.set_edge(60, 70, 1.0f);
+    }
+
+    ssuds::Graph<int, float> graph;
+};
+
+
+TEST_F(GraphDfsTests, TimestampsAndVisitors)
+{
+    ssuds::DepthFirstSearch<int, float> dfs(graph);
+    const ssuds::CsrGraph<int, float>& csr = dfs.graph();
+    ssuds::ArrayList<int> pre_order;
+    ssuds::ArrayList<int> post_order;
+    unsigned int count = dfs.run(10, [&](unsigned int i) { pre_order.append(csr.node_at(i)); },
+                                     [&](unsigned int i) { post_order.append(csr.node_at(i)); });
+    EXPECT_EQ(count, 5);
+    ASSERT_EQ(pre_order.size(), 5);
+    ASSERT_EQ(post_order.size(), 5);
+    EXPECT_EQ(pre_order[0], 10);
+    EXPECT_EQ(post_order[4], 10);
+
+    unsigned int start = csr.index_of(10);
+    EXPECT_EQ(dfs.parent(start), (int)start);
+    EXPECT_EQ(dfs.discovery_time(start), 0);
+    EXPECT_EQ(dfs.finish_time(start), 9);
+    EXPECT_FALSE(dfs.visited(csr.index_of(60)));
+    EXPECT_EQ(dfs.parent(csr.index_of(70)), -1);
+    EXPECT_EQ(dfs.discovery_time(csr.index_of(70)), -1);
+    EXPECT_EQ(dfs.finish_time(csr.index_of(70)), -1);
+
+    // Every tree edge nests the child's interval inside its parent's (the "parenthesis" property)
+    for (unsigned int i = 0; i < csr.num_nodes(); i++)
+    {
+        if (!dfs.visited(i) || i == start)
+            continue;
+        int p = dfs.parent(i);
+        EXPECT_LT(dfs.discovery_time(p), dfs.discovery_time(i));
+        EXPECT_GT(dfs.finish_time(p), dfs.finish_time(i));
+        EXPECT_LT(dfs.discovery_time(i), dfs.finish_time(i));
+    }
+
+    // The visitors are called in timestamp order
+    for (unsigned int k = 1; k < pre_order.size(); k++)
+        EXPECT_LT(dfs.discovery_time(csr.index_of(pre_order[k - 1])), dfs.discovery_time(csr.index_of(pre_order[k])));
+    for (unsigned int k = 1; k < post_order.size(); k++)
+        EXPECT_LT(dfs.finish_time(csr.index_of(post_order[k - 1])), dfs.finish_time(csr.index_of(post_order[k])));
+
+    // A re-run replaces the old results
+    EXPECT_EQ(dfs.run(60), 2);
+    EXPECT_FALSE(dfs.visited(start));
+    EXPECT_EQ(dfs.discovery_time(csr.index_of(60)), 0);
+    EXPECT_EQ(dfs.finish_time(csr.index_of(60)), 3);
+}
+
+
+TEST_F(GraphDfsTests, RunAllGivesTopologicalOrder)
+{
+    ssuds::DepthFirstSearch<int, float> dfs(graph);
+    const ssuds::CsrGraph<int, float>& csr = dfs.graph();
+    ssuds::ArrayList<int> post_order;
+    EXPECT_EQ(dfs.run_all([](unsigned int) {}, [&](unsigned int i) { post_order.append(csr.node_at(i)); }), 7);
+    ASSERT_EQ(post_order.size(), 7);
+
+    // In a DAG, every edge goes from a later-finished node to an earlier-finished one
+    for (unsigned int u = 0; u < csr.num_nodes(); u++)
+    {
+        EXPECT_TRUE(dfs.visited(u));
+        for (unsigned int e = csr.edge_begin(u); e < csr.edge_end(u); e++)
+            EXPECT_GT(dfs.finish_time(u), dfs.finish_time(csr.target(e)));
+    }
+
+    // Each tree of the forest has a root that is its own parent
+    unsigned int num_roots = 0;
+    for (unsigned int i = 0; i < csr.num_nodes(); i++)
+    {
+        if (dfs.parent(i) == (int)i)
+            num_roots++;
+    }
+    EXPECT_GE(num_roots, 2);
+    EXPECT_LE(num_roots, 3);
+}
+
+
+TEST_F(GraphDfsTests, ParentMapAndErrors)
+{
+    ssuds::DepthFirstSearch<int, float> dfs(graph);
+    dfs.run(20);
+    ssuds::UnorderedMap<int, int> parents = dfs.parent_map();
+    EXPECT_EQ(parents.size(), 3);
+    EXPECT_EQ(parents[20], 20);
+    EXPECT_EQ(parents[40], 20);
+    EXPECT_EQ(parents[50], 20);
+
+    EXPECT_THROW(dfs.run(99), std::out_of_range);
+    EXPECT_THROW(dfs.run_index(dfs.graph().num_nodes()), std::out_of_range);
+}
+
+
+/// Runs a search down a path of num_nodes nodes (0 -> 1 -> ... -> num_nodes - 1).  A recursive search would
+/// need one call frame per node here
+static void check_long_path(int num_nodes)
+{
+    ssuds::Graph<int, float> path;
+    for (int i = 0; i < num_nodes; i++)
+        path.add_node(i);
+    for (int i = 0; i + 1 < num_nodes; i++)
+        path.set_edge(i, i + 1, 1.0f);
+
+    ssuds::DepthFirstSearch<int, float> dfs(path);
+    const ssuds::CsrGraph<int, float>& csr = dfs.graph();
+    unsigned int max_depth = 0;
+    unsigned int depth = 0;
+    EXPECT_EQ(dfs.run(0, [&](unsigned int) { if (++depth > max_depth) max_depth = depth; }, [&](unsigned int) { depth--; }), (unsigned int)num_nodes);
+    EXPECT_EQ(max_depth, (unsigned int)num_nodes);
+    EXPECT_EQ(depth, 0);
+
+    unsigned int last = csr.index_of(num_nodes - 1);
+    EXPECT_EQ(dfs.discovery_time(last), num_nodes - 1);
+    EXPECT_EQ(dfs.finish_time(last), num_nodes);
+    EXPECT_EQ(dfs.finish_time(csr.index_of(0)), 2 * num_nodes - 1);
+    EXPECT_EQ(csr.node_at(dfs.parent(last)), num_nodes - 2);
+}
+
+
+TEST(GraphDfsLongTests, LongPath)
+{
+    // Already far past what a recursive search survives (a default 1MB stack overflows after some
+    // tens of thousands of frames)
+    check_long_path(1000000);
+}
+
+#endif
+
+
+#if DO_GRAPH_DFS_TESTS && DO_GRAPH_DFS_HUGE_TESTS
+
+TEST(GraphDfsLongTests, TenMillionNodePath)
+{
+    // Building the 10M-node Graph takes about 2.6GB and 20s, so this one is off by default
+    check_long_path(10000000);
+}
+
+#endif
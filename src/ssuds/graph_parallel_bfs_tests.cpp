@@ -0,0 +1,80 @@
+#define DO_GRAPH_PARALLEL_BFS_TESTS 1
+#if DO_GRAPH_PARALLEL_BFS_TESTS
+
+#include <gtest/gtest.h>
+#include <graph_bfs.h>
+#include <graph_parallel_bfs.h>
+
+TEST(GraphParallelBfsTests, MatchesSerial)
+{
+    // A random graph with a long "tail" so there are both wide and narrow levels
+    ssuds::Graph<int, float> graph;
+    const int num_nodes = 20000;
+    for (int i = 0; i < num_nodes; i++)
+        graph.add_node(i);
+    unsigned int state = 5;
+    for (int i = 0; i < num_nodes * 6; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        int a = (state >> 4) % (num_nodes / 2);
+        state = state * 1664525u + 1013904223u;
+        int b = (state >> 4) % (num_nodes / 2);
+        graph.set_edge(a, b, 1.0f);
+    }
+    for (int i = num_nodes / 2; i < num_nodes - 1; i++)
+        graph.set_edge(i - 1, i, 1.0f);
+
+    ssuds::CsrGraph<int, float> csr = graph.freeze();
+    ssuds::BreadthFirstSearch<int, float> serial(csr);
+    unsigned int serial_reached = serial.run(0);
+
+    for (unsigned int threads : {1u, 2u, 4u, 8u})
+    {
+        ssuds::ParallelBreadthFirstSearch<int, float> parallel(csr, threads);
+        EXPECT_EQ(parallel.num_threads(), threads);
+        // Run twice to make sure the engine resets properly
+        for (int rep = 0; rep < 2; rep++)
+        {
+            EXPECT_EQ(parallel.run(0), serial_reached);
+            ssuds::ArrayList<int> parents = parallel.parents();
+            for (unsigned int i = 0; i < csr.num_nodes(); i++)
+            {
+                ASSERT_EQ(parents[i], serial.parent(i));
+                ASSERT_EQ(parallel.level(i), serial.level(i));
+                ASSERT_EQ(parallel.reached(i), serial.reached(i));
+            }
+        }
+    }
+    // The last node has no edges leading to it
+    ssuds::ParallelBreadthFirstSearch<int, float> parallel(graph, 3);
+    parallel.run(0);
+    EXPECT_FALSE(parallel.reached(parallel.graph().index_of(num_nodes - 1)));
+}
+
+
+TEST(GraphParallelBfsTests, ParentMapAndErrors)
+{
+    ssuds::Graph<char, int> small;
+    for (char c : {'a', 'b', 'c', 'd'})
+        small.add_node(c);
+    small.set_edge('a', 'b', 1);
+    small.set_edge('a', 'c', 1);
+    small.set_edge('b', 'd', 1);
+    small.set_edge('c', 'd', 1);
+
+    ssuds::ParallelBreadthFirstSearch<char, int> bfs(small, 2);
+    EXPECT_THROW(bfs.run('x'), std::out_of_range);
+    EXPECT_EQ(bfs.run('a'), 4);
+    ssuds::UnorderedMap<char, char> parents = bfs.parent_map();
+    EXPECT_EQ(parents.size(), 4);
+    EXPECT_EQ((*parents.find('a')).second, 'a');
+    EXPECT_EQ((*parents.find('b')).second, 'a');
+    // d has two candidate parents -- it must get the lower-indexed one
+    const ssuds::CsrGraph<char, int>& csr = bfs.graph();
+    char expected = csr.index_of('b') < csr.index_of('c') ? 'b' : 'c';
+    EXPECT_EQ((*parents.find('d')).second, expected);
+    EXPECT_EQ(bfs.run('d'), 1);
+    EXPECT_EQ(bfs.parent(csr.index_of('a')), -1);
+}
+
+#endif
@@ -0,0 +1,185 @@
+#define DO_SHORTEST_PATH_TESTS 1
+#define DO_SHORTEST_PATH_BENCHMARK 0
+
+#include <gtest/gtest.h>
+#include <graph_shortest_path.h>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#if DO_SHORTEST_PATH_TESTS
+
+class ShortestPathTests : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        // The same (symmetric) weights as the first few edges of media/output.txt
+        for (int i = 0; i < 6; i++)
+            graph.add_node(i);
+        add_both(0, 1, 76.9f);
+        add_both(0, 2, 78.3f);
+        add_both(2, 1, 81.3f);
+        add_both(2, 3, 50.0f);
+        add_both(1, 3, 200.0f);
+        add_both(3, 4, 10.0f);
+    }
+
+    void add_both(int a, int b, float w)
+    {
+        graph.set_edge(a, b, w);
+        graph.set_edge(b, a, w);
+    }
+
+    ssuds::Graph<int, float> graph;
+};
+
+
+TEST_F(ShortestPathTests, Dijkstra)
+{
+    ssuds::ShortestPaths<int, float> result = ssuds::shortest_path(graph, 0);
+    EXPECT_EQ(result.source(), 0);
+    EXPECT_FLOAT_EQ(result.distance(0), 0.0f);
+    EXPECT_FLOAT_EQ(result.distance(1), 76.9f);
+    EXPECT_FLOAT_EQ(result.distance(3), 128.3f);
+    EXPECT_FLOAT_EQ(result.distance(4), 138.3f);
+    EXPECT_FALSE(result.reached(5));
+    EXPECT_THROW(result.distance(5), std::out_of_range);
+    EXPECT_EQ(result.path_to(5).size(), 0);
+
+    ssuds::ArrayList<int> path = result.path_to(4);
+    ssuds::ArrayList<int> path_true{ 0, 2, 3, 4 };
+    ASSERT_EQ(path.size(), path_true.size());
+    for (unsigned int i = 0; i < path.size(); i++)
+        EXPECT_EQ(path[i], path_true[i]);
+    EXPECT_EQ(result.predecessors().size(), 4);
+    EXPECT_EQ(result.distances().size(), 5);
+
+    EXPECT_THROW(ssuds::shortest_path(graph, 99), std::out_of_range);
+}
+
+
+TEST_F(ShortestPathTests, AStarMatchesDijkstra)
+{
+    // Nodes on a grid, with straight-line distance as the (admissible) heuristic
+    ssuds::Graph<int, float> grid;
+    const int width = 30;
+    for (int i = 0; i < width * width; i++)
+        grid.add_node(i);
+    for (int r = 0; r < width; r++)
+    {
+        for (int c = 0; c < width; c++)
+        {
+            int id = r * width + c;
+            float extra = (float)((id * 7919) % 5);
+            if (c + 1 < width)
+            {
+                grid.set_edge(id, id + 1, 1.0f + extra);
+                grid.set_edge(id + 1, id, 1.0f + extra);
+            }
+            if (r + 1 < width)
+            {
+                grid.set_edge(id, id + width, 1.0f + extra);
+                grid.set_edge(id + width, id, 1.0f + extra);
+            }
+        }
+    }
+    const int goal_row = 4, goal_col = 20;
+    const int goal = goal_row * width + goal_col;
+    auto heuristic = [](const int& n) { return std::fabs((float)(goal_col - n % width)) + std::fabs((float)(goal_row - n / width)); };
+
+    ssuds::ShortestPaths<int, float> all = ssuds::shortest_path(grid, 0);
+    ssuds::ShortestPaths<int, float> dij = ssuds::shortest_path(grid, 0, goal);
+    ssuds::ShortestPaths<int, float> astar = ssuds::shortest_path<4>(grid, 0, goal, heuristic);
+    EXPECT_FLOAT_EQ(dij.distance(goal), all.distance(goal));
+    EXPECT_FLOAT_EQ(astar.distance(goal), all.distance(goal));
+
+    // The path must be made of real edges that add up to the distance
+    ssuds::ArrayList<int> path = astar.path_to(goal);
+    ASSERT_GE(path.size(), 2);
+    EXPECT_EQ(path[0], 0);
+    EXPECT_EQ(path[path.size() - 1], goal);
+    float total = 0.0f;
+    for (unsigned int i = 0; i + 1 < path.size(); i++)
+        total += grid.get_edge(path[i], path[i + 1]);
+    EXPECT_FLOAT_EQ(total, all.distance(goal));
+
+    // A* should reach fewer nodes than an unguided search
+    EXPECT_LT(astar.distances().size(), all.distances().size());
+}
+
+
+TEST_F(ShortestPathTests, EarlyExitOnlyReportsSettledNodes)
+{
+    //   0 --1--> 1
+    //   0 --2--> 2 (the destination)
+    //   0 --100--> 3, but 0 --5--> 4 --1--> 3 is shorter
+    ssuds::Graph<int, float> G;
+    for (int i = 0; i < 5; i++)
+        G.add_node(i);
+    G.set_edge(0, 1, 1.0f);
+    G.set_edge(0, 2, 2.0f);
+    G.set_edge(0, 3, 100.0f);
+    G.set_edge(0, 4, 5.0f);
+    G.set_edge(4, 3, 1.0f);
+
+    // 3 and 4 were only relaxed (3 with a too-long tentative distance) when 2 was settled
+    ssuds::ShortestPaths<int, float> result = ssuds::shortest_path(G, 0, 2);
+    EXPECT_FLOAT_EQ(result.distance(2), 2.0f);
+    EXPECT_TRUE(result.reached(1));
+    EXPECT_FALSE(result.reached(3));
+    EXPECT_FALSE(result.reached(4));
+    EXPECT_THROW(result.distance(3), std::out_of_range);
+    EXPECT_EQ(result.path_to(3).size(), 0);
+    EXPECT_EQ(result.distances().size(), 3);
+    EXPECT_EQ(result.predecessors().size(), 2);
+
+    ssuds::ShortestPaths<int, float> all = ssuds::shortest_path(G, 0);
+    EXPECT_FLOAT_EQ(all.distance(3), 6.0f);
+    ssuds::ArrayList<int> path = all.path_to(3);
+    ASSERT_EQ(path.size(), 3);
+    EXPECT_EQ(path[1], 4);
+}
+
+#endif
+
+
+#if DO_SHORTEST_PATH_BENCHMARK
+
+template <unsigned int D>
+double time_shortest_path(const ssuds::Graph<int, float>& G, int num_nodes)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int src = 0; src < 5; src++)
+        ssuds::shortest_path<D>(G, src * (num_nodes / 5));
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+TEST(ShortestPathBenchmark, HeapArities)
+{
+    // A large random weighted graph (average out-degree 8)
+    const int num_nodes = 200000;
+    const int num_edges = num_nodes * 8;
+    ssuds::Graph<int, float> G;
+    for (int i = 0; i < num_nodes; i++)
+        G.add_node(i);
+    unsigned int state = 2024;
+    for (int i = 0; i < num_edges; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        int a = state % num_nodes;
+        state = state * 1664525u + 1013904223u;
+        int b = state % num_nodes;
+        state = state * 1664525u + 1013904223u;
+        G.set_edge(a, b, 1.0f + (state >> 8) % 1000);
+    }
+
+    std::cout << "Dijkstra x5 on " << num_nodes << " nodes / " << num_edges << " edges" << std::endl;
+    std::cout << "  2-ary heap: " << time_shortest_path<2>(G, num_nodes) << "s" << std::endl;
+    std::cout << "  3-ary heap: " << time_shortest_path<3>(G, num_nodes) << "s" << std::endl;
+    std::cout << "  4-ary heap: " << time_shortest_path<4>(G, num_nodes) << "s" << std::endl;
+    std::cout << "  8-ary heap: " << time_shortest_path<8>(G, num_nodes) << "s" << std::endl;
+}
+
+#endif
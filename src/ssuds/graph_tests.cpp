@@ -146,4 +146,141 @@ TEST_F(GraphTests, OStream)
     }
 }
 
+
+TEST_F(GraphTests, Degrees)
+{
+    EXPECT_EQ(int_graph.num_neighbors('a'), 2);
+    EXPECT_EQ(int_graph.num_neighbors('b'), 0);
+    EXPECT_EQ(int_graph.in_degree('a'), 1);
+    EXPECT_EQ(int_graph.in_degree('b'), 1);
+    EXPECT_EQ(int_graph.in_degree('f'), 0);
+    EXPECT_THROW(int_graph.in_degree('x'), std::out_of_range);
+    EXPECT_THROW(int_graph.find_incoming('a'), std::logic_error);
+}
+
+
+TEST_F(GraphTests, IncomingIndex)
+{
+    // Build the same graph with the index on from the start, and switch it on for the fixture's graph
+    ssuds::Graph<char, int> tracked(true);
+    for (char c : {'a', 'b', 'c', 'd', 'e', 'f'})
+        tracked.add_node(c);
+    tracked.set_edge('a', 'b', 15);
+    tracked.set_edge('d', 'e', 18);
+    tracked.set_edge('a', 'c', 32);
+    tracked.set_edge('c', 'a', 33);
+    tracked.set_edge('f', 'b', 4);
+    tracked.set_edge('b', 'b', 1);
+    int_graph.set_edge('f', 'b', 4);
+    int_graph.set_edge('b', 'b', 1);
+    EXPECT_FALSE(int_graph.tracks_incoming());
+    int_graph.enable_incoming_index();
+    EXPECT_TRUE(int_graph.tracks_incoming());
+
+    for (ssuds::Graph<char, int>* G : {&tracked, &int_graph})
+    {
+        EXPECT_EQ(G->in_degree('b'), 3);
+        std::map<char, bool> preds;
+        typename ssuds::UnorderedMap<char, ssuds::UnorderedMap<char, bool>>::UnorderedMapIterator it = G->find_incoming('b');
+        ASSERT_NE(it, G->find_incoming('x'));
+        for (std::pair<char, bool> p : (*it).second)
+            preds[p.first] = true;
+        EXPECT_EQ(preds.size(), 3);
+        EXPECT_TRUE(preds['a'] && preds['f'] && preds['b']);
+
+        // Removing an edge updates the index
+        EXPECT_TRUE(G->remove_edge('f', 'b'));
+        EXPECT_FALSE(G->remove_edge('f', 'b'));
+        EXPECT_EQ(G->in_degree('b'), 2);
+
+        // Removing a node removes the edges to / from it (including its self-loop)
+        EXPECT_TRUE(G->remove_node('b'));
+        EXPECT_FALSE(G->remove_node('b'));
+        EXPECT_FALSE(G->contains_node('b'));
+        EXPECT_FALSE(G->contains_edge('a', 'b'));
+        EXPECT_EQ(G->num_neighbors('a'), 1);
+        EXPECT_TRUE(G->remove_node('a'));
+        EXPECT_EQ(G->in_degree('c'), 0);
+        EXPECT_EQ(G->num_neighbors('c'), 0);
+        EXPECT_EQ(G->in_degree('e'), 1);
+        EXPECT_EQ(G->num_nodes(), 4);
+
+        G->clear();
+        EXPECT_EQ(G->num_nodes(), 0);
+        G->add_node('z');
+        EXPECT_EQ(G->in_degree('z'), 0);
+    }
+}
+
+
+TEST_F(GraphTests, IncomingIndexChurn)
+{
+    // Randomly add / remove nodes and edges and check the index against a brute-force count
+    ssuds::Graph<int, int> tracked(true);
+    ssuds::Graph<int, int> plain;
+    const int num = 60;
+    for (int i = 0; i < num; i++)
+    {
+        tracked.add_node(i);
+        plain.add_node(i);
+    }
+    unsigned int state = 12345;
+    for (int step = 0; step < 2000; step++)
+    {
+        state = state * 1103515245u + 12345u;
+        int a = (state >> 8) % num;
+        int b = (state >> 16) % num;
+        int action = (state >> 24) % 10;
+        if (action < 6 && tracked.contains_node(a) && tracked.contains_node(b))
+        {
+            tracked.set_edge(a, b, step);
+            plain.set_edge(a, b, step);
+        }
+        else if (action < 8)
+        {
+            EXPECT_EQ(tracked.remove_edge(a, b), plain.remove_edge(a, b));
+        }
+        else if (action == 8)
+        {
+            EXPECT_EQ(tracked.remove_node(a), plain.remove_node(a));
+        }
+        else
+        {
+            tracked.add_node(a);
+            plain.add_node(a);
+        }
+    }
+
+    ASSERT_EQ(tracked.num_nodes(), plain.num_nodes());
+    for (int i = 0; i < num; i++)
+    {
+        ASSERT_EQ(tracked.contains_node(i), plain.contains_node(i));
+        if (!plain.contains_node(i))
+            continue;
+        EXPECT_EQ(tracked.in_degree(i), plain.in_degree(i));
+        EXPECT_EQ(tracked.num_neighbors(i), plain.num_neighbors(i));
+        for (int j = 0; j < num; j++)
+            EXPECT_EQ(tracked.contains_edge(i, j), plain.contains_edge(i, j));
+    }
+}
+
+TEST(GraphReserveTests, ReserveNodesAndEdges)
+{
+    ssuds::Graph<int, float> G;
+    G.reserve_nodes(1000);
+    for (int i = 0; i < 1000; i++)
+        G.add_node(i);
+    EXPECT_EQ(G.num_nodes(), 1000);
+
+    G.reserve_edges(0, 200);
+    size_t cap = (*G.find(0)).second.capacity();
+    for (int i = 1; i <= 200; i++)
+        G.set_edge(0, i, (float)i);
+    EXPECT_EQ((*G.find(0)).second.capacity(), cap);
+    EXPECT_EQ(G.num_neighbors(0), 200);
+    EXPECT_TRUE(G.contains_edge(0, 200));
+
+    EXPECT_THROW(G.reserve_edges(5000, 10), std::out_of_range);
+}
+
 #endif
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <ordered_set.h>
+#include <cmath>
 
 #define DO_ORDERED_SET_TESTS 1
 #if DO_ORDERED_SET_TESTS
@@ -62,16 +63,17 @@ TEST_F(OrderedSetTests, RemoveAndContains)
 TEST_F(OrderedSetTests, TreeString)
 {
     std::stringstream strue;
+    // The shape after the AVL rotations done by the inserts in SetUp
     strue << "Doug" << std::endl;
-    strue << "   L: Abe" << std::endl;
-    strue << "      R: Bob" << std::endl;
-    strue << "         R: Carl" << std::endl;
-    strue << "            R: Carline" << std::endl;
-    strue << "               R: Dan" << std::endl;
-    strue << "   R: Erin" << std::endl;
+    strue << "   L: Bob" << std::endl;
+    strue << "      L: Abe" << std::endl;
+    strue << "      R: Carline" << std::endl;
+    strue << "         L: Carl" << std::endl;
+    strue << "         R: Dan" << std::endl;
+    strue << "   R: Erica" << std::endl;
     strue << "      L: Eric" << std::endl;
-    strue << "         R: Erica" << std::endl;
-    strue << "            R: Ericaz" << std::endl;
+    strue << "      R: Erin" << std::endl;
+    strue << "         L: Ericaz" << std::endl;
 
     std::string s = s1.tree_string();
     EXPECT_EQ(s, strue.str());
@@ -83,10 +85,10 @@ TEST_F(OrderedSetTests, TraversalTest)
     ssuds::ArrayList<std::string> in_true {"Abe", "Bob", "Carl", "Carline", "Dan", "Doug", "Eric", "Erica", "Ericaz", "Erin"};
     ssuds::ArrayList<std::string> in_test = s1.traversal(ssuds::TraversalType::IN_ORDER);
 
-    ssuds::ArrayList<std::string> pre_true {"Doug", "Abe", "Bob", "Carl", "Carline", "Dan", "Erin", "Eric", "Erica", "Ericaz"};
+    ssuds::ArrayList<std::string> pre_true {"Doug", "Bob", "Abe", "Carline", "Carl", "Dan", "Erica", "Eric", "Erin", "Ericaz"};
     ssuds::ArrayList<std::string> pre_test = s1.traversal(ssuds::TraversalType::PRE_ORDER);
 
-    ssuds::ArrayList<std::string> post_true {"Dan", "Carline", "Carl", "Bob", "Abe", "Ericaz", "Erica", "Eric", "Erin", "Doug"};
+    ssuds::ArrayList<std::string> post_true {"Abe", "Carl", "Dan", "Carline", "Bob", "Eric", "Ericaz", "Erin", "Erica", "Doug"};
     ssuds::ArrayList<std::string> post_test = s1.traversal(ssuds::TraversalType::POST_ORDER);
 
     ASSERT_EQ(in_true.size(), in_test.size());
@@ -122,7 +124,7 @@ TEST_F(OrderedSetTests, IteratorTest)
 TEST_F(OrderedSetTests, Rebalance)
 {
     EXPECT_EQ(s1.size(), 10);
-    EXPECT_EQ(s1.get_height(), 6);
+    EXPECT_EQ(s1.get_height(), 4);
     s1.rebalance();
     EXPECT_EQ(s1.size(), 10);
     EXPECT_EQ(s1.get_height(), 4);
@@ -176,4 +178,277 @@ TEST_F(OrderedSetTests, SetOperations)
 }
 
 
+TEST(OrderedSetBalanceTests, SortedInsertsStayBalanced)
+{
+    // An unbalanced tree would be a 100000-node linked list here.  An AVL tree's height is at most
+    // 1.44 * log2(n + 2), which is about 24 for this size
+    const int num = 100000;
+    ssuds::OrderedSet<int> s;
+    for (int i = 0; i < num; i++)
+    {
+        EXPECT_TRUE(s.insert(i));
+        if ((i & (i + 1)) == 0)
+        {
+            EXPECT_LE(s.get_height(), 1.44 * std::log2(i + 3.0));
+        }
+    }
+    EXPECT_EQ(s.size(), num);
+    EXPECT_LE(s.get_height(), 24);
+
+    // Descending inserts are the mirror image
+    ssuds::OrderedSet<int> t;
+    for (int i = num; i > 0; i--)
+        t.insert(i);
+    EXPECT_LE(t.get_height(), 24);
+
+    // Erasing keeps it balanced too (erase every other value, then most of the low half)
+    for (int i = 0; i < num; i += 2)
+        EXPECT_TRUE(s.erase(i));
+    for (int i = 1; i < num / 2; i += 2)
+        EXPECT_TRUE(s.erase(i));
+    EXPECT_EQ(s.size(), num / 4);
+    EXPECT_LE(s.get_height(), 1.44 * std::log2(num / 4 + 2.0));
+    int expected = num / 2 + 1;
+    for (int v : s)
+    {
+        EXPECT_EQ(v, expected);
+        expected += 2;
+    }
+    EXPECT_FALSE(s.contains(0));
+    EXPECT_TRUE(s.contains(num - 1));
+}
+
+
+
+TEST(OrderedSetBalanceTests, IterationAndTraversalsAfterChurn)
+{
+    // Mixes inserts and erases (lots of rotations), then checks that iteration -- which follows the
+    // parent pointers -- and the traversals agree with a plain sorted list of the survivors
+    const int num = 20000;
+    ssuds::OrderedSet<int> s;
+    for (int i = 0; i < num; i++)
+        s.insert((i * 7919) % num);
+    for (int i = 0; i < num; i += 3)
+        EXPECT_TRUE(s.erase((i * 104729) % num));
+    for (int i = 0; i < num; i += 5)
+        s.insert(i);
+
+    ssuds::ArrayList<int> expected;
+    for (int i = 0; i < num; i++)
+    {
+        if (s.contains(i))
+            expected.append(i);
+    }
+    ASSERT_EQ(s.size(), expected.size());
+
+    unsigned int pos = 0;
+    for (int v : s)
+    {
+        ASSERT_LT(pos, expected.size());
+        EXPECT_EQ(v, expected[pos++]);
+    }
+    EXPECT_EQ(pos, expected.size());
+
+    ssuds::ArrayList<int> in_order = s.traversal(ssuds::TraversalType::IN_ORDER);
+    ssuds::ArrayList<int> pre_order = s.traversal(ssuds::TraversalType::PRE_ORDER);
+    ssuds::ArrayList<int> post_order = s.traversal(ssuds::TraversalType::POST_ORDER);
+    ASSERT_EQ(in_order.size(), expected.size());
+    ASSERT_EQ(pre_order.size(), expected.size());
+    ASSERT_EQ(post_order.size(), expected.size());
+    for (unsigned int i = 0; i < expected.size(); i++)
+        EXPECT_EQ(in_order[i], expected[i]);
+
+    // Both other orders visit every value once, starting / ending at the root
+    EXPECT_EQ(pre_order[0], post_order[post_order.size() - 1]);
+    ssuds::OrderedSet<int> pre_set, post_set;
+    for (unsigned int i = 0; i < expected.size(); i++)
+    {
+        EXPECT_TRUE(pre_set.insert(pre_order[i]));
+        EXPECT_TRUE(post_set.insert(post_order[i]));
+    }
+    pos = 0;
+    for (int v : pre_set)
+        EXPECT_EQ(v, expected[pos++]);
+    pos = 0;
+    for (int v : post_set)
+        EXPECT_EQ(v, expected[pos++]);
+
+    ssuds::OrderedSet<int> empty;
+    EXPECT_TRUE(empty.begin() == empty.end());
+    EXPECT_EQ(empty.traversal(ssuds::TraversalType::POST_ORDER).size(), 0);
+    EXPECT_EQ(empty.tree_string(), "");
+    s.clear();
+    EXPECT_TRUE(s.begin() == s.end());
+}
+
+
+
+TEST_F(OrderedSetTests, SetOperationsInPlace)
+{
+    ssuds::OrderedSet<int> set1{ 1, 5, 7, 3, 2, 9, 13 };
+    ssuds::OrderedSet<int> set2{ 5, 2, 13, 99, 73 };
+
+    ssuds::OrderedSet<int> u = set1;
+    u |= set2;
+    ssuds::ArrayList<int> u_test = u.traversal(ssuds::TraversalType::IN_ORDER);
+    ssuds::ArrayList<int> u_true{ 1, 2, 3, 5, 7, 9, 13, 73, 99 };
+    ASSERT_EQ(u_test.size(), u_true.size());
+    for (unsigned int i = 0; i < u_true.size(); i++)
+        EXPECT_EQ(u_test[i], u_true[i]);
+
+    ssuds::OrderedSet<int> n = set1;
+    n &= set2;
+    ssuds::ArrayList<int> n_test = n.traversal(ssuds::TraversalType::IN_ORDER);
+    ssuds::ArrayList<int> n_true{ 2, 5, 13 };
+    ASSERT_EQ(n_test.size(), n_true.size());
+    for (unsigned int i = 0; i < n_true.size(); i++)
+        EXPECT_EQ(n_test[i], n_true[i]);
+
+    ssuds::OrderedSet<int> d = set2;
+    d -= set1;
+    ssuds::ArrayList<int> d_test = d.traversal(ssuds::TraversalType::IN_ORDER);
+    ssuds::ArrayList<int> d_true{ 73, 99 };
+    ASSERT_EQ(d_test.size(), d_true.size());
+    for (unsigned int i = 0; i < d_true.size(); i++)
+        EXPECT_EQ(d_test[i], d_true[i]);
+
+    // A set combined with itself (or an empty set)
+    ssuds::OrderedSet<int> empty;
+    u |= u;
+    EXPECT_EQ(u.size(), u_true.size());
+    u &= u;
+    EXPECT_EQ(u.size(), u_true.size());
+    u |= empty;
+    EXPECT_EQ(u.size(), u_true.size());
+    EXPECT_EQ((u & empty).size(), 0);
+    EXPECT_EQ((empty - u).size(), 0);
+    u -= u;
+    EXPECT_EQ(u.size(), 0);
+    EXPECT_TRUE(u.begin() == u.end());
+
+    // The results are ordinary sets that can keep changing
+    EXPECT_TRUE(n.insert(4));
+    EXPECT_TRUE(n.erase(13));
+    EXPECT_TRUE(n.contains(4));
+    EXPECT_EQ(n.size(), 3);
+}
+
+
+TEST(OrderedSetBalanceTests, LargeSetOperations)
+{
+    // Multiples of 2 and multiples of 3 below num
+    const int num = 60000;
+    ssuds::OrderedSet<int> twos, threes;
+    for (int i = 0; i < num; i += 2)
+        twos.insert(i);
+    for (int i = 0; i < num; i += 3)
+        threes.insert(i);
+
+    ssuds::OrderedSet<int> both = twos & threes;
+    ssuds::OrderedSet<int> either = twos | threes;
+    ssuds::OrderedSet<int> only_twos = twos - threes;
+    EXPECT_EQ(both.size(), num / 6);
+    EXPECT_EQ(either.size(), num / 2 + num / 3 - num / 6);
+    EXPECT_EQ(only_twos.size(), num / 2 - num / 6);
+
+    // The results are built perfectly balanced
+    EXPECT_LE(either.get_height(), (unsigned int)std::ceil(std::log2(either.size() + 1.0)));
+
+    int expected = 0;
+    for (int v : both)
+    {
+        EXPECT_EQ(v, expected);
+        expected += 6;
+    }
+    for (int v : either)
+        EXPECT_TRUE(v % 2 == 0 || v % 3 == 0);
+    for (int v : only_twos)
+        EXPECT_TRUE(v % 2 == 0 && v % 3 != 0);
+}
+
+
+
+TEST_F(OrderedSetTests, OrderStatistics)
+{
+    ssuds::ArrayList<std::string> in_true {"Abe", "Bob", "Carl", "Carline", "Dan", "Doug", "Eric", "Erica", "Ericaz", "Erin"};
+    for (unsigned int i = 0; i < in_true.size(); i++)
+    {
+        EXPECT_EQ(s1.rank(in_true[i]), i);
+        EXPECT_EQ(s1.select(i), in_true[i]);
+        EXPECT_EQ(*s1.lower_bound(in_true[i]), in_true[i]);
+    }
+    EXPECT_THROW(s1.select(10), std::out_of_range);
+    EXPECT_EQ(s1.rank("A"), 0);
+    EXPECT_EQ(s1.rank("Cat"), 4);
+    EXPECT_EQ(s1.rank("Zed"), 10);
+
+    EXPECT_EQ(*s1.lower_bound("Cat"), "Dan");
+    EXPECT_EQ(*s1.upper_bound("Carl"), "Carline");
+    EXPECT_EQ(*s1.upper_bound("Carla"), "Carline");
+    EXPECT_TRUE(s1.lower_bound("Zed") == s1.end());
+    EXPECT_TRUE(s1.upper_bound("Erin") == s1.end());
+
+    // Iterators from lower_bound keep going in order
+    ssuds::OrderedSet<std::string>::OrderedSetIterator it = s1.lower_bound("Doug");
+    ++it;
+    EXPECT_EQ(*it, "Eric");
+
+    EXPECT_EQ(s1.count_range("Bob", "Dan"), 4);
+    EXPECT_EQ(s1.count_range("Bz", "Dz"), 4);
+    EXPECT_EQ(s1.count_range("Dan", "Bob"), 0);
+    EXPECT_EQ(s1.count_range("A", "Zed"), 10);
+    EXPECT_EQ(s1.count_range("Erin", "Erin"), 1);
+
+    ssuds::ArrayList<std::string> visited;
+    s1.for_each_in_range("Carline", "Eric", [&](const std::string& v) { visited.append(v); });
+    ssuds::ArrayList<std::string> visited_true {"Carline", "Dan", "Doug", "Eric"};
+    ASSERT_EQ(visited.size(), visited_true.size());
+    for (unsigned int i = 0; i < visited.size(); i++)
+        EXPECT_EQ(visited[i], visited_true[i]);
+}
+
+
+TEST(OrderedSetBalanceTests, OrderStatisticsAfterChurn)
+{
+    // The subtree counts have to survive the rotations done by inserts and erases (and the rebuilds done
+    // by the set operators and rebalance)
+    const int num = 5000;
+    ssuds::OrderedSet<int> s;
+    for (int i = 0; i < num; i++)
+        s.insert((i * 7919) % num);
+    for (int i = 0; i < num; i += 3)
+        s.erase((i * 104729) % num);
+    s |= ssuds::OrderedSet<int>{ -5, num + 5 };
+
+    ssuds::ArrayList<int> sorted = s.traversal(ssuds::TraversalType::IN_ORDER);
+    ASSERT_EQ(sorted.size(), s.size());
+    for (unsigned int i = 0; i < sorted.size(); i++)
+    {
+        EXPECT_EQ(s.select(i), sorted[i]);
+        EXPECT_EQ(s.rank(sorted[i]), i);
+        EXPECT_EQ(s.rank(sorted[i] + 1), i + 1);
+    }
+
+    for (int lo = -10; lo < num + 10; lo += 97)
+    {
+        int hi = lo + 250;
+        unsigned int expected = 0;
+        for (unsigned int i = 0; i < sorted.size(); i++)
+        {
+            if (sorted[i] >= lo && sorted[i] <= hi)
+                expected++;
+        }
+        EXPECT_EQ(s.count_range(lo, hi), expected);
+        unsigned int visited = 0;
+        int last = lo - 1;
+        s.for_each_in_range(lo, hi, [&](int v) { EXPECT_GT(v, last); EXPECT_LE(v, hi); last = v; visited++; });
+        EXPECT_EQ(visited, expected);
+    }
+
+    s.rebalance();
+    for (unsigned int i = 0; i < sorted.size(); i += 7)
+        EXPECT_EQ(s.select(i), sorted[i]);
+}
+
+
 #endif
\ No newline at end of file
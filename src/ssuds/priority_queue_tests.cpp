@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <priority_queue.h>
+#include <string>
+
+#define DO_PRIORITY_QUEUE_TESTS 1
+#if DO_PRIORITY_QUEUE_TESTS
+
+TEST(PriorityQueueTests, BasicOperations)
+{
+	ssuds::PriorityQueue<std::string, int> Q;
+	EXPECT_TRUE(Q.empty());
+	EXPECT_EQ(Q.size(), 0u);
+	EXPECT_THROW(Q.top(), std::out_of_range);
+	EXPECT_THROW(Q.pop(), std::out_of_range);
+	Q.push("c", 30);
+	Q.push("a", 10);
+	Q.push("d", 40);
+	Q.push("b", 20);
+	EXPECT_EQ(Q.size(), 4u);
+	EXPECT_EQ(Q.top(), "a");
+	EXPECT_EQ(Q.top_priority(), 10);
+	EXPECT_EQ(Q.pop(), "a");
+	EXPECT_EQ(Q.pop(), "b");
+	Q.push("e", 5);
+	EXPECT_EQ(Q.pop(), "e");
+	EXPECT_EQ(Q.pop(), "c");
+	EXPECT_EQ(Q.size(), 1u);
+	Q.clear();
+	EXPECT_TRUE(Q.empty());
+}
+
+
+template <unsigned int D>
+void check_heap_order()
+{
+	// Push pseudo-random priorities (with duplicates) and make sure they come out sorted
+	ssuds::PriorityQueue<int, int, D> Q;
+	unsigned int state = 7;
+	const int num = 5000;
+	for (int i = 0; i < num; i++)
+	{
+		state = state * 1103515245u + 12345u;
+		int p = (state >> 8) % 1000;
+		Q.push(p * 10, p);
+	}
+	ASSERT_EQ(Q.size(), (unsigned int)num);
+	int last = -1;
+	for (int i = 0; i < num; i++)
+	{
+		int p = Q.top_priority();
+		EXPECT_EQ(Q.pop(), p * 10);
+		EXPECT_LE(last, p);
+		last = p;
+	}
+	EXPECT_TRUE(Q.empty());
+}
+
+TEST(PriorityQueueTests, Arities)
+{
+	check_heap_order<2>();
+	check_heap_order<3>();
+	check_heap_order<4>();
+	check_heap_order<8>();
+}
+
+#endif
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <thread_pool.h>
+#include <atomic>
+#include <stdexcept>
+
+#define DO_THREAD_POOL_TESTS 1
+#if DO_THREAD_POOL_TESTS
+
+TEST(ThreadPoolTests, EveryTaskRunsOnce)
+{
+	for (unsigned int threads : {1u, 2u, 4u, 7u})
+	{
+		ssuds::ThreadPool pool(threads);
+		EXPECT_EQ(pool.num_threads(), threads);
+		const unsigned int num = 10000;
+		std::atomic<int>* counts = new std::atomic<int>[num];
+		for (unsigned int i = 0; i < num; i++)
+			counts[i] = 0;
+		std::atomic<bool> bad_worker(false);
+
+		// Run a few jobs on the same pool (with uneven task costs so stealing happens)
+		for (int job = 0; job < 3; job++)
+		{
+			pool.parallel_for(num, [&](unsigned int task, unsigned int worker)
+			{
+				if (worker >= threads)
+					bad_worker = true;
+				volatile unsigned int spin = 0;
+				for (unsigned int i = 0; i < (task % 97) * 10; i++)
+					spin = spin + i;
+				counts[task]++;
+			});
+		}
+		for (unsigned int i = 0; i < num; i++)
+			EXPECT_EQ(counts[i], 3);
+		EXPECT_FALSE(bad_worker);
+		delete[] counts;
+	}
+}
+
+
+TEST(ThreadPoolTests, Exceptions)
+{
+	// A one-thread pool runs the tasks itself, without the worker threads, but keeps the same contract
+	for (unsigned int num_threads : { 4u, 1u })
+	{
+		ssuds::ThreadPool pool(num_threads);
+		std::atomic<int> ran(0);
+		EXPECT_THROW(pool.parallel_for(100, [&](unsigned int task, unsigned int)
+		{
+			ran++;
+			if (task == 42 || task == 57)
+				throw std::runtime_error(task == 42 ? "task 42 failed" : "task 57 failed");
+		}), std::runtime_error);
+		EXPECT_EQ(ran, 100) << num_threads << " threads";
+
+		// The pool is still usable afterwards
+		ran = 0;
+		pool.parallel_for(10, [&](unsigned int, unsigned int) { ran++; });
+		EXPECT_EQ(ran, 10);
+		pool.parallel_for(0, [&](unsigned int, unsigned int) { ran++; });
+		EXPECT_EQ(ran, 10);
+	}
+
+	// With one thread the tasks run in order, so the first exception is task 42's
+	ssuds::ThreadPool serial(1);
+	try
+	{
+		serial.parallel_for(100, [&](unsigned int task, unsigned int)
+		{
+			if (task == 42 || task == 57)
+				throw std::runtime_error(task == 42 ? "task 42 failed" : "task 57 failed");
+		});
+		FAIL() << "expected an exception";
+	}
+	catch (const std::runtime_error& e)
+	{
+		EXPECT_STREQ(e.what(), "task 42 failed");
+	}
+}
+
+#endif
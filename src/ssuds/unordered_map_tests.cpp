@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <unordered_map.h>
+#include <unordered_map>
 
 class UnorderedMapTestFixture : public ::testing::Test
 {
@@ -175,3 +176,203 @@ TEST_F(UnorderedMapTestFixture, Remove)
 	it = um.find("Bob");
 	EXPECT_EQ(it, um.end());
 }
+
+
+
+/// Counts how many instances are alive, so we can check that the map's inline slots
+/// construct / destroy exactly the pairs they hold
+class LiveCounter
+{
+public:
+	static int msLive;
+	int mValue;
+	LiveCounter(int value = 0) : mValue(value) { msLive++; }
+	LiveCounter(const LiveCounter& other) : mValue(other.mValue) { msLive++; }
+	LiveCounter& operator=(const LiveCounter& other) { mValue = other.mValue; return *this; }
+	~LiveCounter() { msLive--; }
+};
+int LiveCounter::msLive = 0;
+
+
+TEST(UnorderedMapStorageTests, ElementLifetimes)
+{
+	{
+		ssuds::UnorderedMap<int, LiveCounter> m;
+		for (int i = 0; i < 100; i++)
+			m[i] = LiveCounter(i * 2);
+		EXPECT_EQ(LiveCounter::msLive, 100);
+
+		ssuds::UnorderedMap<int, LiveCounter> copy(m);
+		EXPECT_EQ(LiveCounter::msLive, 200);
+		copy = m;
+		EXPECT_EQ(LiveCounter::msLive, 200);
+		copy.clear();
+		EXPECT_EQ(LiveCounter::msLive, 100);
+
+		for (int i = 0; i < 100; i += 2)
+			EXPECT_EQ(m.remove(i).mValue, i * 2);
+		EXPECT_EQ(LiveCounter::msLive, 50);
+		for (int i = 1; i < 100; i += 2)
+			EXPECT_EQ(m[i].mValue, i * 2);
+	}
+	EXPECT_EQ(LiveCounter::msLive, 0);
+}
+
+
+TEST(UnorderedMapStorageTests, NestedMapsSurviveGrowth)
+{
+	// The values are themselves maps, which get moved (not copied) when the outer table grows
+	ssuds::UnorderedMap<int, ssuds::UnorderedMap<int, float>> m;
+	for (int i = 0; i < 500; i++)
+	{
+		m[i];
+		for (int j = 0; j < i % 7; j++)
+			m[i][j] = (float)(i + j);
+	}
+	EXPECT_EQ(m.size(), 500);
+	for (int i = 0; i < 500; i++)
+	{
+		ssuds::UnorderedMap<int, ssuds::UnorderedMap<int, float>>::UnorderedMapIterator it = m.find(i);
+		ASSERT_NE(it, m.end());
+		EXPECT_EQ((*it).second.size(), (size_t)(i % 7));
+		for (int j = 0; j < i % 7; j++)
+			EXPECT_EQ((*it).second[j], (float)(i + j));
+	}
+
+	ssuds::UnorderedMap<int, ssuds::UnorderedMap<int, float>> moved(std::move(m));
+	EXPECT_EQ(moved.size(), 500);
+	EXPECT_EQ(m.size(), 0);
+	m = std::move(moved);
+	EXPECT_EQ(m[499][1], 500.0f);
+}
+
+
+TEST(UnorderedMapStorageTests, GroupProbing)
+{
+	// Dense, sparse and negative integer keys (lots of them share hash fragments)
+	ssuds::UnorderedMap<int, int> m;
+	for (int i = 0; i < 20000; i++)
+		m[i % 2 == 0 ? i : -i * 4096] = i;
+	EXPECT_EQ(m.size(), 20000);
+
+	// The capacity stays a power of two
+	EXPECT_EQ(m.capacity() & (m.capacity() - 1), 0);
+
+	for (int i = 0; i < 20000; i++)
+	{
+		ssuds::UnorderedMap<int, int>::UnorderedMapIterator it = m.find(i % 2 == 0 ? i : -i * 4096);
+		ASSERT_NE(it, m.end());
+		EXPECT_EQ((*it).second, i);
+	}
+	for (int i = 1; i < 20000; i += 2)
+		EXPECT_EQ(m.find(i), m.end());
+
+	// Every pair is visited exactly once by iteration
+	long long total = 0;
+	size_t count = 0;
+	for (std::pair<int, int> p : m)
+	{
+		total += p.second;
+		count++;
+	}
+	EXPECT_EQ(count, 20000);
+	EXPECT_EQ(total, 19999LL * 20000 / 2);
+
+	// Small tables (fewer slots than a probe group) still work
+	ssuds::UnorderedMap<std::string, int> small;
+	small["a"] = 1;
+	small["b"] = 2;
+	EXPECT_EQ(small.capacity(), INITIAL_MAP_CAPACITY);
+	EXPECT_EQ(small["a"], 1);
+	EXPECT_EQ(small["b"], 2);
+	EXPECT_EQ(small.find("c"), small.end());
+}
+
+
+TEST(UnorderedMapStorageTests, RemoveChurn)
+{
+	// Interleave adds and removes (and compare against std::unordered_map), so the backward-shift
+	// deletion gets exercised on clusters that wrap around the end of the table
+	ssuds::UnorderedMap<int, int> m;
+	std::unordered_map<int, int> reference;
+	unsigned int state = 12345;
+	for (int step = 0; step < 50000; step++)
+	{
+		state = state * 1664525u + 1013904223u;
+		int key = (int)((state >> 8) % 3000);
+		if (reference.count(key))
+		{
+			EXPECT_EQ(m.remove(key), reference[key]);
+			reference.erase(key);
+		}
+		else
+		{
+			m[key] = step;
+			reference[key] = step;
+		}
+	}
+	EXPECT_EQ(m.size(), reference.size());
+	for (int key = 0; key < 3000; key++)
+	{
+		ssuds::UnorderedMap<int, int>::UnorderedMapIterator it = m.find(key);
+		if (reference.count(key))
+		{
+			ASSERT_NE(it, m.end());
+			EXPECT_EQ((*it).second, reference[key]);
+		}
+		else
+			EXPECT_EQ(it, m.end());
+	}
+	EXPECT_THROW(m.remove(-1), std::out_of_range);
+
+	// Removing never re-allocates the table
+	size_t cap = m.capacity();
+	for (std::pair<const int, int> p : reference)
+		m.remove(p.first);
+	EXPECT_EQ(m.size(), 0);
+	EXPECT_EQ(m.capacity(), cap);
+	EXPECT_EQ(m.begin(), m.end());
+}
+
+
+TEST(UnorderedMapStorageTests, ReserveRehashInsert)
+{
+	// After a reserve, adding that many pairs never grows the table
+	ssuds::UnorderedMap<int, int> m;
+	m.reserve(1000);
+	size_t cap = m.capacity();
+	EXPECT_GE((float)cap * MAX_LOAD_FACTOR, 1000.0f);
+	for (int i = 0; i < 1000; i++)
+		m[i] = i;
+	EXPECT_EQ(m.capacity(), cap);
+
+	// reserve never shrinks
+	m.reserve(10);
+	EXPECT_EQ(m.capacity(), cap);
+
+	// rehash can shrink (but only down to what the pairs need) or grow
+	for (int i = 0; i < 990; i++)
+		m.remove(i);
+	m.rehash(0);
+	EXPECT_EQ(m.capacity(), INITIAL_MAP_CAPACITY * 2);
+	m.rehash(100);
+	EXPECT_EQ(m.capacity(), 128);
+	for (int i = 990; i < 1000; i++)
+		EXPECT_EQ(m[i], i);
+	EXPECT_EQ(m.size(), 10);
+
+	// Bulk-insert from another map and from a list of pairs
+	ssuds::UnorderedMap<int, int> copy;
+	copy.insert(m.begin(), m.end());
+	EXPECT_EQ(copy.size(), 10);
+	EXPECT_EQ(copy[995], 995);
+
+	ssuds::ArrayList<std::pair<int, int>> pairs;
+	for (int i = 0; i < 500; i++)
+		pairs.append(std::pair<int, int>(i, -i));
+	pairs.append(std::pair<int, int>(995, 7));
+	copy.insert(pairs.begin(), pairs.end());
+	EXPECT_EQ(copy.size(), 510);
+	EXPECT_EQ(copy[995], 7);
+	EXPECT_EQ(copy[499], -499);
+}